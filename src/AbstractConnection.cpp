@@ -17,6 +17,8 @@
  *****************************************************************************/
 
 #include "AbstractConnection.h"
+#include "DataSink.h"
+#include "IoChannel.h"
 #include "Site.h"
 
 namespace UJ
@@ -28,10 +30,81 @@ namespace Connection
 AbstractConnection::AbstractConnection(QObject *parent) : QObject(parent)
 {
     _site = 0;
+    _channel = 0;
+    _sink = 0;
+    resetChunkStats();
     setProcessing(false);
     setConnected(false);
 }
 
+AbstractConnection::~AbstractConnection()
+{
+    // Lives on the reactor, so it has to be deleted there
+    if (_channel)
+        _channel->release();
+}
+
+void AbstractConnection::setChannel(IoChannel *channel)
+{
+    _channel = channel;
+    connect(_channel, SIGNAL(readable()), this, SLOT(readChannel()));
+}
+
+void AbstractConnection::setSink(DataSink *sink)
+{
+    _sink = sink;
+}
+
+double AbstractConnection::chunksPerSecond() const
+{
+    qint64 msecs = _statsClock.elapsed();
+    return msecs > 0 ? _chunksReceived * 1000.0 / msecs : 0.0;
+}
+
+double AbstractConnection::averageChunkSize() const
+{
+    if (_chunksReceived == 0)
+        return 0.0;
+    return static_cast<double>(_bytesReceived) / _chunksReceived;
+}
+
+void AbstractConnection::resetChunkStats()
+{
+    _chunksReceived = 0;
+    _bytesReceived = 0;
+    _statsClock.start();
+}
+
+void AbstractConnection::readChannel()
+{
+    QByteArray chunk;
+    while (_channel->read(&chunk))
+        receiveChunk(chunk);
+    endBatch();
+}
+
+void AbstractConnection::receiveChunk(const QByteArray &bytes)
+{
+    _chunksReceived++;
+    _bytesReceived += bytes.size();
+    emit receivedBytes(bytes);
+    processBytes(bytes);
+}
+
+// Called by processBytes() with what is left for the terminal
+void AbstractConnection::deliver(const QByteArray &bytes)
+{
+    if (_sink)
+        _sink->receiveData(bytes);
+    emit processedBytes(bytes);
+}
+
+void AbstractConnection::endBatch()
+{
+    if (_sink)
+        _sink->endBatch();
+}
+
 void AbstractConnection::setSite(Site *site)
 {
     if (_site)
@@ -19,6 +19,7 @@
 #ifndef ABSTRACTCONNECTION_H
 #define ABSTRACTCONNECTION_H
 
+#include <QElapsedTimer>
 #include <QObject>
 
 namespace UJ
@@ -29,6 +30,8 @@ class Terminal;
 namespace Connection
 {
 
+class DataSink;
+class IoChannel;
 class Site;
 
 class AbstractConnection : public QObject
@@ -37,17 +40,46 @@ class AbstractConnection : public QObject
 
 public:
     explicit AbstractConnection(QObject *parent = 0);
+    virtual ~AbstractConnection();
     virtual bool connectTo(Site *s);
     virtual bool connectTo(const QString &address, qint16 port) = 0;
     static const qint16 DefaultPort = -1;
 
+    // Received data is handed straight to the sink, if there is one;
+    // processedBytes() is still emitted for anything else that listens
+    void setSink(DataSink *sink);
+
+    // Chunks as read from the connection, before the protocol is taken out,
+    // since the stats were last reset
+    inline qint64 chunksReceived() const
+    {
+        return _chunksReceived;
+    }
+    inline qint64 bytesReceived() const
+    {
+        return _bytesReceived;
+    }
+    double chunksPerSecond() const;
+    double averageChunkSize() const;
+    void resetChunkStats();
+
 public slots:
     virtual void close() = 0;
     virtual void reconnect() = 0;
     virtual void sendBytes(QByteArray bytes) = 0;
 
 protected:
+    void setChannel(IoChannel *channel);
+    void receiveChunk(const QByteArray &bytes);
+    void deliver(const QByteArray &bytes);
+    void endBatch();
+
     Site *_site;
+    IoChannel *_channel;    // Where the bytes come from, if anywhere
+    DataSink *_sink;
+    qint64 _chunksReceived;
+    qint64 _bytesReceived;
+    QElapsedTimer _statsClock;
     QString _name;
     QString _address;
     // NOTE: Need an image member for tab icon...
@@ -57,12 +89,14 @@ protected:
 
 protected slots:
     virtual void processBytes(QByteArray bytes) = 0;
+    void readChannel();
 
 signals:
     void connected();
     void disconnected();
     void receivedBytes(QByteArray data);
     void processedBytes(QByteArray bytes);
+    void sentBytes(QByteArray bytes);
 
 public: // Getters & Setters
     virtual inline Site *site()
@@ -0,0 +1,77 @@
+/*****************************************************************************
+ * BlinkClock.cpp
+ *
+ * Created: 16/10 2026 by uranusjr
+ *
+ * Copyright 2026 uranusjr. All rights reserved.
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ *****************************************************************************/
+
+#include "BlinkClock.h"
+#include <QApplication>
+#include <QTimer>
+
+namespace UJ
+{
+
+namespace Qelly
+{
+
+BlinkClock::BlinkClock(QObject *parent) :
+    QObject(parent), _on(false), _tickCount(0)
+{
+    _timer = new QTimer(this);
+    _timer->setInterval(QApplication::cursorFlashTime());
+    connect(_timer, SIGNAL(timeout()), this, SLOT(tick()));
+}
+
+void BlinkClock::subscribe(QObject *receiver, const char *member)
+{
+    if (_subscribers.contains(receiver))
+        return;
+    _subscribers.insert(receiver);
+    connect(this, SIGNAL(ticked(bool)), receiver, member);
+    connect(receiver, SIGNAL(destroyed(QObject*)),
+            this, SLOT(forget(QObject*)));
+    if (!_timer->isActive())
+        _timer->start();
+}
+
+void BlinkClock::unsubscribe(QObject *receiver)
+{
+    if (!_subscribers.contains(receiver))
+        return;
+    disconnect(this, 0, receiver, 0);
+    receiver->disconnect(this);
+    forget(receiver);
+}
+
+void BlinkClock::tick()
+{
+    _on = !_on;
+    _tickCount++;
+    emit ticked(_on);
+}
+
+void BlinkClock::forget(QObject *receiver)
+{
+    _subscribers.remove(receiver);
+    if (_subscribers.isEmpty())
+    {
+        _timer->stop();
+        _on = false;
+    }
+}
+
+}   // namespace Qelly
+
+}   // namespace UJ
@@ -0,0 +1,81 @@
+/*****************************************************************************
+ * BlinkClock.h
+ *
+ * Created: 16/10 2026 by uranusjr
+ *
+ * Copyright 2026 uranusjr. All rights reserved.
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ *****************************************************************************/
+
+#ifndef BLINKCLOCK_H
+#define BLINKCLOCK_H
+
+#include <QObject>
+#include <QSet>
+class QTimer;
+
+namespace UJ
+{
+
+namespace Qelly
+{
+
+// The one timer blinking text runs on, shared by every view so that they
+// blink in step. It only runs while something is subscribed to it, and views
+// only subscribe while they are shown and have blinking cells on screen; an
+// idle window with nothing blinking never wakes up for it.
+class BlinkClock : public QObject
+{
+    Q_OBJECT
+
+public:
+    static inline BlinkClock *sharedInstance()
+    {
+        static BlinkClock *g = new BlinkClock();
+        return g;
+    }
+
+    explicit BlinkClock(QObject *parent = 0);
+
+    // Connects ticked(bool) to member of receiver, like QObject::connect
+    void subscribe(QObject *receiver, const char *member);
+    void unsubscribe(QObject *receiver);
+
+    inline bool isOn() const
+    {
+        return _on;
+    }
+    // Times the clock has woken up, for measuring idle wakeups
+    inline qint64 tickCount() const
+    {
+        return _tickCount;
+    }
+
+signals:
+    void ticked(bool on);
+
+private slots:
+    void tick();
+    void forget(QObject *receiver);
+
+private:
+    QTimer *_timer;
+    QSet<QObject *> _subscribers;
+    bool _on;
+    qint64 _tickCount;
+};
+
+}   // namespace Qelly
+
+}   // namespace UJ
+
+#endif // BLINKCLOCK_H
@@ -0,0 +1,452 @@
+/*****************************************************************************
+ * BlockGlyphs.cpp
+ *
+ * Created: 16/10 2026 by uranusjr
+ *
+ * Copyright 2026 uranusjr. All rights reserved.
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ *****************************************************************************/
+
+#include "BlockGlyphs.h"
+#include <QColor>
+#include <QPainter>
+#include <QPainterPath>
+#include <QPen>
+#include <QPolygon>
+#include <QRect>
+
+namespace UJ
+{
+
+namespace Qelly
+{
+
+namespace
+{
+
+enum Weight
+{
+    WeightNone,
+    WeightLight,
+    WeightHeavy,
+    WeightDouble
+};
+
+enum Arm
+{
+    ArmUp,
+    ArmRight,
+    ArmDown,
+    ArmLeft
+};
+
+// The lines of U+2500 to U+257F, reaching from the middle of the cell to its
+// edges: a Weight of two bits for each Arm, starting from the lowest bits.
+// Dashes, arcs and diagonals are drawn their own way, but the arms still say
+// where their lines go.
+const uchar BoxArms[128] = {
+    0x44, 0x88, 0x11, 0x22, 0x44, 0x88, 0x11, 0x22,     // U+2500
+    0x44, 0x88, 0x11, 0x22, 0x14, 0x18, 0x24, 0x28,     // U+2508
+    0x50, 0x90, 0x60, 0xa0, 0x05, 0x09, 0x06, 0x0a,     // U+2510
+    0x41, 0x81, 0x42, 0x82, 0x15, 0x19, 0x16, 0x25,     // U+2518
+    0x26, 0x1a, 0x29, 0x2a, 0x51, 0x91, 0x52, 0x61,     // U+2520
+    0x62, 0x92, 0xa1, 0xa2, 0x54, 0x94, 0x58, 0x98,     // U+2528
+    0x64, 0xa4, 0x68, 0xa8, 0x45, 0x85, 0x49, 0x89,     // U+2530
+    0x46, 0x86, 0x4a, 0x8a, 0x55, 0x95, 0x59, 0x99,     // U+2538
+    0x56, 0x65, 0x66, 0x96, 0x5a, 0xa5, 0x69, 0x9a,     // U+2540
+    0xa9, 0xa6, 0x6a, 0xaa, 0x44, 0x88, 0x11, 0x22,     // U+2548
+    0xcc, 0x33, 0x1c, 0x34, 0x3c, 0xd0, 0x70, 0xf0,     // U+2550
+    0x0d, 0x07, 0x0f, 0xc1, 0x43, 0xc3, 0x1d, 0x37,     // U+2558
+    0x3f, 0xd1, 0x73, 0xf3, 0xdc, 0x74, 0xfc, 0xcd,     // U+2560
+    0x47, 0xcf, 0xdd, 0x77, 0xff, 0x14, 0x50, 0x41,     // U+2568
+    0x05, 0x00, 0x00, 0x00, 0x40, 0x01, 0x04, 0x10,     // U+2570
+    0x80, 0x02, 0x08, 0x20, 0x48, 0x21, 0x84, 0x12      // U+2578
+};
+
+// U+2596 to U+259F, as the quadrants they fill: upper left, upper right,
+// lower left and lower right, from the lowest bit
+const uchar Quadrants[10] = {
+    0x4, 0x8, 0x1, 0xd, 0x9, 0x7, 0xb, 0x2, 0x6, 0xe
+};
+
+// DEC Special Graphics, 0x5f to 0x7e
+const ushort DecSpecialGraphics[32] = {
+    0x00a0, 0x25c6, 0x2592, 0x2409, 0x240c, 0x240d, 0x240a, 0x00b0,
+    0x00b1, 0x2424, 0x240b, 0x2518, 0x2510, 0x250c, 0x2514, 0x253c,
+    0x23ba, 0x23bb, 0x2500, 0x23bc, 0x23bd, 0x251c, 0x2524, 0x2534,
+    0x252c, 0x2502, 0x2264, 0x2265, 0x03c0, 0x2260, 0x00a3, 0x00b7
+};
+
+inline int armAt(uchar arms, Arm arm)
+{
+    return (arms >> (arm * 2)) & 3;
+}
+
+// Everything below works in whole pixels, computed the same way for every
+// cell, so that lines meet the ones in the cells next to them exactly.
+struct Box
+{
+    Box(QPainter *painter, const QRect &rect, const QColor &color) :
+        painter(painter), color(color), left(rect.left()), top(rect.top()),
+        right(rect.left() + rect.width()), bottom(rect.top() + rect.height()),
+        centerX(rect.left() + rect.width() / 2),
+        centerY(rect.top() + rect.height() / 2),
+        light(qMax(1, rect.height() / 16))
+    {
+    }
+
+    inline int thickness(int weight) const
+    {
+        return weight == WeightHeavy ? light * 2 + 1 : light;
+    }
+
+    // A line along one axis; begin and end are along it, across is where
+    // the line starts on the other one
+    inline void line(bool vertical, int begin, int end, int across,
+                     int width) const
+    {
+        if (begin > end)
+            qSwap(begin, end);
+        if (vertical)
+            painter->fillRect(across, begin, width, end - begin, color);
+        else
+            painter->fillRect(begin, across, end - begin, width, color);
+    }
+
+    void arm(uchar arms, Arm which) const;
+    void dashes(uchar arms, int count) const;
+    void arc(uchar arms) const;
+    void diagonal(bool down, bool up) const;
+
+    QPainter *painter;
+    QColor color;
+    int left;
+    int top;
+    int right;
+    int bottom;
+    int centerX;
+    int centerY;
+    int light;
+};
+
+void Box::arm(uchar arms, Arm which) const
+{
+    int weight = armAt(arms, which);
+    if (!weight)
+        return;
+
+    // The arm runs from the lines crossing it near the center to the edge.
+    // Side A is the crossing arm with the lower coordinate (up for a
+    // horizontal arm, left for a vertical one).
+    bool vertical = which == ArmUp || which == ArmDown;
+    bool forward = which == ArmRight || which == ArmDown;
+    int sideA = armAt(arms, vertical ? ArmLeft : ArmUp);
+    int sideB = armAt(arms, vertical ? ArmRight : ArmDown);
+    int opposite = armAt(arms, Arm((which + 2) % 4));
+    int center = vertical ? centerY : centerX;
+    int across = vertical ? centerX : centerY;
+    int edge = vertical ? (forward ? bottom : top) : (forward ? right : left);
+
+    // Where the arm meets a single crossing line, and the outer and inner
+    // line of a double one
+    int single = qMax(sideA == WeightDouble ? 0 : sideA,
+                      sideB == WeightDouble ? 0 : sideB);
+    int singleWidth = single ? thickness(single) : 0;
+    int singleLow = center - singleWidth / 2;
+    int doubleLow = center - light * 3 / 2;
+    int singleEdge = forward ? singleLow : singleLow + singleWidth;
+    int outerEdge = forward ? doubleLow : doubleLow + light * 3;
+    int innerEdge = forward ? doubleLow + light * 2 : doubleLow + light;
+
+    if (weight != WeightDouble)
+    {
+        int begin = center;
+        if (sideA == WeightDouble || sideB == WeightDouble)
+            begin = opposite ? outerEdge : innerEdge;
+        else if (single)
+            begin = singleEdge;
+        int width = thickness(weight);
+        line(vertical, begin, edge, across - width / 2, width);
+        return;
+    }
+
+    // Each of the two lines turns into the crossing arm on its own side,
+    // goes straight on into a double opposite arm, or else closes off the
+    // corner with the crossing arm on the other side
+    int low = across - light * 3 / 2;
+    for (int i = 0; i < 2; i++)
+    {
+        int own = i ? sideB : sideA;
+        int other = i ? sideA : sideB;
+        int begin = center;
+        if (own)
+            begin = own == WeightDouble ? innerEdge : singleEdge;
+        else if (opposite == WeightDouble)
+            begin = center;
+        else if (other)
+            begin = other == WeightDouble ? outerEdge : singleEdge;
+        line(vertical, begin, edge, low + i * light * 2, light);
+    }
+}
+
+void Box::dashes(uchar arms, int count) const
+{
+    // Each dash sits in the middle of an equal slot, so the gaps between
+    // cells are the same as the ones inside them
+    bool vertical = armAt(arms, ArmUp);
+    int weight = armAt(arms, vertical ? ArmUp : ArmLeft);
+    int width = thickness(weight);
+    int begin = vertical ? top : left;
+    int length = vertical ? bottom - top : right - left;
+    int across = (vertical ? centerX : centerY) - width / 2;
+    for (int i = 0; i < count; i++)
+    {
+        line(vertical, begin + length * (4 * i + 1) / (4 * count),
+             begin + length * (4 * i + 3) / (4 * count), across, width);
+    }
+}
+
+void Box::arc(uchar arms) const
+{
+    bool up = armAt(arms, ArmUp);
+    bool leftward = armAt(arms, ArmLeft);
+    qreal x = centerX - light / 2 + light / 2.0;
+    qreal y = centerY - light / 2 + light / 2.0;
+    qreal radius = qMin(right - left, bottom - top) / 2.0;
+
+    QPainterPath path;
+    path.moveTo(x, up ? top : bottom);
+    path.lineTo(x, up ? y - radius : y + radius);
+    path.quadTo(x, y, leftward ? x - radius : x + radius, y);
+    path.lineTo(leftward ? left : right, y);
+    painter->save();
+    painter->setRenderHint(QPainter::Antialiasing);
+    painter->strokePath(path, QPen(color, light, Qt::SolidLine, Qt::FlatCap));
+    painter->restore();
+}
+
+void Box::diagonal(bool down, bool up) const
+{
+    painter->save();
+    painter->setRenderHint(QPainter::Antialiasing);
+    painter->setPen(QPen(color, light, Qt::SolidLine, Qt::FlatCap));
+    if (down)
+        painter->drawLine(QPointF(left, top), QPointF(right, bottom));
+    if (up)
+        painter->drawLine(QPointF(left, bottom), QPointF(right, top));
+    painter->restore();
+}
+
+void drawBlockElement(QPainter *painter, ushort code, const QRect &rect,
+                      const QColor &color)
+{
+    // Block elements come in eighths of the cell
+    int x = rect.left();
+    int y = rect.top();
+    int w = rect.width();
+    int h = rect.height();
+    int n;
+    switch (code)
+    {
+    case 0x2580:    // ▀ Upper half block
+        painter->fillRect(x, y, w, h / 2, color);
+        break;
+    case 0x2581:    // ▁ Lower one eighth block
+    case 0x2582:    // ▂ Lower one quarter block
+    case 0x2583:    // ▃ Lower three eighths block
+    case 0x2584:    // ▄ Lower half block
+    case 0x2585:    // ▅ Lower five eighths block
+    case 0x2586:    // ▆ Lower three quarters block
+    case 0x2587:    // ▇ Lower seven eighths block
+    case 0x2588:    // █ Full block
+        n = h - h * (8 - (code - 0x2580)) / 8;
+        painter->fillRect(x, y + h - n, w, n, color);
+        break;
+    case 0x2589:    // ▉ Left seven eighths block
+    case 0x258a:    // ▊ Left three quarters block
+    case 0x258b:    // ▋ Left five eighths block
+    case 0x258c:    // ▌ Left half block
+    case 0x258d:    // ▍ Left three eighths block
+    case 0x258e:    // ▎ Left one quarter block
+    case 0x258f:    // ▏ Left one eighth block
+        painter->fillRect(x, y, w * (0x2590 - code) / 8, h, color);
+        break;
+    case 0x2590:    // ▐ Right half block
+        painter->fillRect(x + w / 2, y, w - w / 2, h, color);
+        break;
+    case 0x2591:    // ░ Light shade
+    case 0x2592:    // ▒ Medium shade
+    case 0x2593:    // ▓ Dark shade
+    {
+        QColor shade(color);
+        shade.setAlpha(64 * (code - 0x2590));
+        painter->fillRect(x, y, w, h, shade);
+        break;
+    }
+    case 0x2594:    // ▔ Upper one eighth block
+        painter->fillRect(x, y, w, h / 8, color);
+        break;
+    case 0x2595:    // ▕ Right one eighth block
+        painter->fillRect(x + w - w / 8, y, w / 8, h, color);
+        break;
+    default:        // Quadrants
+        n = Quadrants[code - 0x2596];
+        if (n & 0x1)
+            painter->fillRect(x, y, w / 2, h / 2, color);
+        if (n & 0x2)
+            painter->fillRect(x + w / 2, y, w - w / 2, h / 2, color);
+        if (n & 0x4)
+            painter->fillRect(x, y + h / 2, w / 2, h - h / 2, color);
+        if (n & 0x8)
+            painter->fillRect(x + w / 2, y + h / 2, w - w / 2, h - h / 2,
+                              color);
+        break;
+    }
+}
+
+void drawBoxDrawing(QPainter *painter, ushort code, const QRect &rect,
+                    const QColor &color)
+{
+    Box box(painter, rect, color);
+    uchar arms = BoxArms[code - 0x2500];
+    switch (code)
+    {
+    case 0x2504:    // ┄ Triple dashes
+    case 0x2505:
+    case 0x2506:
+    case 0x2507:
+        box.dashes(arms, 3);
+        break;
+    case 0x2508:    // ┈ Quadruple dashes
+    case 0x2509:
+    case 0x250a:
+    case 0x250b:
+        box.dashes(arms, 4);
+        break;
+    case 0x254c:    // ╌ Double dashes
+    case 0x254d:
+    case 0x254e:
+    case 0x254f:
+        box.dashes(arms, 2);
+        break;
+    case 0x256d:    // ╭ Arcs
+    case 0x256e:
+    case 0x256f:
+    case 0x2570:
+        box.arc(arms);
+        break;
+    case 0x2571:    // ╱ Diagonals
+    case 0x2572:
+    case 0x2573:
+        box.diagonal(code != 0x2571, code != 0x2572);
+        break;
+    default:
+        box.arm(arms, ArmUp);
+        box.arm(arms, ArmRight);
+        box.arm(arms, ArmDown);
+        box.arm(arms, ArmLeft);
+        break;
+    }
+}
+
+void drawShape(QPainter *painter, ushort code, const QRect &rect,
+               const QColor &color)
+{
+    int l = rect.left();
+    int t = rect.top();
+    int r = rect.left() + rect.width();
+    int b = rect.top() + rect.height();
+    QPolygon triangle;
+    switch (code)
+    {
+    case 0x23ba:    // ⎺ Horizontal scan line 1
+    case 0x23bb:    // ⎻ Horizontal scan line 3
+    case 0x23bc:    // ⎼ Horizontal scan line 7
+    case 0x23bd:    // ⎽ Horizontal scan line 9
+    {
+        // Scan lines 1 to 9 split the cell into nine bands; 5 is U+2500
+        static const int lines[4] = {1, 3, 7, 9};
+        Box box(painter, rect, color);
+        int y = t + rect.height() * (2 * lines[code - 0x23ba] - 1) / 18;
+        box.line(false, l, r, y - box.light / 2, box.light);
+        return;
+    }
+    case 0x25e2:    // ◢ Black lower right triangle
+        triangle << QPoint(r, t) << QPoint(r, b) << QPoint(l, b);
+        break;
+    case 0x25e3:    // ◣ Black lower left triangle
+        triangle << QPoint(l, t) << QPoint(r, b) << QPoint(l, b);
+        break;
+    case 0x25e4:    // ◤ Black upper left triangle
+        triangle << QPoint(l, t) << QPoint(r, t) << QPoint(l, b);
+        break;
+    case 0x25e5:    // ◥ Black upper right triangle
+        triangle << QPoint(l, t) << QPoint(r, t) << QPoint(r, b);
+        break;
+    case 0x25fc:    // ◼ Black medium square, painted as a full block
+        painter->fillRect(rect, color);
+        return;
+    default:
+        return;
+    }
+    painter->save();
+    painter->setRenderHint(QPainter::Antialiasing);
+    painter->setPen(Qt::NoPen);
+    painter->setBrush(color);
+    painter->drawPolygon(triangle);
+    painter->restore();
+}
+
+}   // namespace
+
+bool isBlockGlyph(ushort code)
+{
+    if (code >= 0x2500 && code <= 0x259f)
+        return true;
+    switch (code)
+    {
+    case 0x23ba:
+    case 0x23bb:
+    case 0x23bc:
+    case 0x23bd:
+    case 0x25e2:
+    case 0x25e3:
+    case 0x25e4:
+    case 0x25e5:
+    case 0x25fc:
+        return true;
+    default:
+        return false;
+    }
+}
+
+void drawBlockGlyph(QPainter *painter, ushort code, const QRect &rect,
+                    const QColor &color)
+{
+    if (code >= 0x2500 && code <= 0x257f)
+        drawBoxDrawing(painter, code, rect, color);
+    else if (code >= 0x2580 && code <= 0x259f)
+        drawBlockElement(painter, code, rect, color);
+    else
+        drawShape(painter, code, rect, color);
+}
+
+ushort decSpecialGraphic(uchar c)
+{
+    if (c < 0x5f || c > 0x7e)
+        return c;
+    return DecSpecialGraphics[c - 0x5f];
+}
+
+}   // namespace Qelly
+
+}   // namespace UJ
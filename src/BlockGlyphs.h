@@ -0,0 +1,53 @@
+/*****************************************************************************
+ * BlockGlyphs.h
+ *
+ * Created: 16/10 2026 by uranusjr
+ *
+ * Copyright 2026 uranusjr. All rights reserved.
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ *****************************************************************************/
+
+#ifndef BLOCKGLYPHS_H
+#define BLOCKGLYPHS_H
+
+#include <QtGlobal>
+class QColor;
+class QPainter;
+class QRect;
+
+namespace UJ
+{
+
+namespace Qelly
+{
+
+// Characters drawn from their geometry instead of from a font: the box
+// drawing (U+2500 to U+257F) and block element (U+2580 to U+259F) ranges,
+// the horizontal scan lines of DEC Special Graphics, and the geometric shapes
+// BBS art fills cells with. Drawn this way they cover the cells exactly, so
+// lines and blocks join up across cells without gaps whatever the font is.
+bool isBlockGlyph(ushort code);
+
+// Draws the character to fill rect, which is the one or two cells the
+// character takes up. The background is left alone.
+void drawBlockGlyph(QPainter *painter, ushort code, const QRect &rect,
+                    const QColor &color);
+
+// The character a byte stands for in the DEC Special Graphics set, which
+// replaces 0x5f to 0x7e; other bytes stand for themselves.
+ushort decSpecialGraphic(uchar c);
+
+}   // namespace Qelly
+
+}   // namespace UJ
+
+#endif // BLOCKGLYPHS_H
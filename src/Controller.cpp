@@ -18,11 +18,17 @@
 
 #include "Controller.h"
 #include <QApplication>
+#include <QDateTime>
+#include <QDir>
 #include <QLineEdit>
 #include <QMessageBox>
+#include <QRegExp>
 #include "Globals.h"
+#include "GlyphCache.h"
 #include "MainWindow.h"
 #include "PreferencesWindow.h"
+#include "Replay.h"
+#include "SessionRecording.h"
 #include "SharedMenuBar.h"
 #include "SharedPreferences.h"
 #include "TabWidget.h"
@@ -56,6 +62,8 @@ Controller::Controller(QObject *parent) : QObject(parent)
 
     SharedPreferences *prefs = SharedPreferences::sharedInstance();
     _window->setContentHeight(prefs->cellHeight() * BBS::SizeRowCount);
+    GlyphCache::sharedInstance()->setDiskCacheDirectory(
+                prefs->glyphCacheDirectory());
     _window->show();
     addTab();
 }
@@ -75,7 +83,15 @@ void Controller::connectWithAddress(QString address)
     Connection::Terminal *terminal = new Connection::Terminal(view);
     Connection::AbstractConnection *connection;
     qint16 defaultPort = Connection::AbstractConnection::DefaultPort;
-    if (address.startsWith("ssh://"))
+    bool isReplay = false;
+    if (address.startsWith("replay://"))
+    {
+        address = address.section("://", 1);
+        connection = new Connection::Replay(terminal);
+        terminal->setConnection(connection);
+        isReplay = true;
+    }
+    else if (address.startsWith("ssh://"))
     {
         address = address.section("://", 1);
         connection = new Connection::Ssh(terminal);
@@ -101,8 +117,20 @@ void Controller::connectWithAddress(QString address)
     connect(view, SIGNAL(shouldChangeAddress(const QString &)),
             this, SLOT(changeAddressField(const QString &)));
 
+    SharedPreferences *prefs = SharedPreferences::sharedInstance();
+    if (!isReplay && !prefs->recordingDirectory().isEmpty())
+    {
+        QString stamp = QDateTime::currentDateTime().toString(
+                    "yyyyMMdd-hhmmss");
+        QString host = address;
+        host.replace(QRegExp("[^A-Za-z0-9._-]"), "_");
+        QString path = QDir(prefs->recordingDirectory()).filePath(
+                    QString("%1-%2.qrec").arg(host, stamp));
+        new Connection::SessionRecorder(path, connection);
+    }
+
     QStringList comps = address.split(':');
-    if (comps.size() == 1)
+    if (comps.size() == 1 || isReplay)
         connection->connectTo(address, defaultPort);
     else
         connection->connectTo(comps.first(), comps.last().toLong());
@@ -278,7 +306,10 @@ void Controller::showPreferencesWindow()
 
 void Controller::updateAll()
 {
-    // TODO: Implement me #13
+    // Views switch to the new settings on their next frame
+    SharedPreferences *prefs = SharedPreferences::sharedInstance();
+    prefs->commitRenderSettings();
+    _window->setContentHeight(prefs->cellHeight() * BBS::SizeRowCount);
 }
 
 View *Controller::currentView() const
@@ -0,0 +1,189 @@
+/*****************************************************************************
+ * CsiParameters.h
+ *
+ * Created: 16/10 2026 by uranusjr
+ *
+ * Copyright 2026 uranusjr. All rights reserved.
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ *****************************************************************************/
+
+#ifndef CSIPARAMETERS_H
+#define CSIPARAMETERS_H
+
+#include <QtGlobal>
+
+namespace UJ
+{
+
+namespace Connection
+{
+
+// Parameters, private prefix and intermediates of the control sequence being
+// parsed. Everything lives in fixed arrays inside the object, so parsing a
+// sequence never allocates; starting a new one only resets a few indices.
+//
+// Overflow is handled the way xterm does it:
+//  - A value saturates at MaxValue instead of wrapping around.
+//  - Parameters beyond Capacity and intermediates beyond
+//    IntermediateCapacity are dropped, and overflowed() becomes true.
+//
+// A parameter introduced by ':' instead of ';' is a sub-parameter of the one
+// before it, as in "38:5:196". Omitted parameters read as 0, except for a
+// trailing one: "1;33;m" is the same as "1;33", not a reset at the end. Art
+// on BBSes relies on that, like other BBS clients do.
+//
+// Handlers read the parameters in order with isEmpty(), head() and
+// dequeue(), like a queue that is never shrunk or reallocated.
+class CsiParameters
+{
+public:
+    static const int Capacity = 32;
+    static const int IntermediateCapacity = 2;
+    static const int MaxValue = 0xffff;
+
+    CsiParameters()
+    {
+        clear();
+    }
+
+    inline void clear()
+    {
+        _count = 0;
+        _next = 0;
+        _subMask = 0;
+        _value = 0;
+        _pending = false;
+        _pendingIsSub = false;
+        _prefix = 0;
+        _intermediateCount = 0;
+        _overflowed = false;
+        _valid = true;
+    }
+
+    // Parsing
+    inline void addDigit(uchar c)
+    {
+        _value = _value * 10 + (c - '0');
+        if (_value > MaxValue)
+            _value = MaxValue;
+        _pending = true;
+    }
+    inline void addSeparator(uchar c)
+    {
+        push();
+        _pendingIsSub = (c == ':');
+    }
+    inline void setPrefix(uchar c)
+    {
+        // Only valid as the very first byte of the sequence
+        if (_pending || _count || _prefix)
+            _valid = false;
+        else
+            _prefix = c;
+    }
+    inline void addIntermediate(uchar c)
+    {
+        if (_intermediateCount < IntermediateCapacity)
+            _intermediates[_intermediateCount++] = c;
+        else
+            _overflowed = true;
+    }
+    inline void finish()
+    {
+        if (_pending)
+            push();
+    }
+
+    // Reading
+    inline bool isValid() const
+    {
+        return _valid;
+    }
+    inline bool overflowed() const
+    {
+        return _overflowed;
+    }
+    inline uchar prefix() const
+    {
+        return _prefix;
+    }
+    inline int intermediateCount() const
+    {
+        return _intermediateCount;
+    }
+    inline uchar intermediate(int i) const
+    {
+        return _intermediates[i];
+    }
+    inline bool isEmpty() const
+    {
+        return _next >= _count;
+    }
+    inline int size() const
+    {
+        return _count - _next;
+    }
+    inline int head() const
+    {
+        return _values[_next];
+    }
+    inline int dequeue()
+    {
+        return _values[_next++];
+    }
+    inline bool headIsSubParameter() const
+    {
+        return !isEmpty() && (_subMask & (quint32(1) << _next));
+    }
+    inline void skipSubParameters()
+    {
+        while (headIsSubParameter())
+            _next++;
+    }
+
+private:
+    inline void push()
+    {
+        if (_count < Capacity)
+        {
+            if (_pendingIsSub)
+                _subMask |= quint32(1) << _count;
+            _values[_count++] = _value;
+        }
+        else
+        {
+            _overflowed = true;
+        }
+        _value = 0;
+        _pending = false;
+        _pendingIsSub = false;
+    }
+
+    int _values[Capacity];
+    quint32 _subMask;       // Bit i is set if parameter i follows a ':'
+    int _count;
+    int _next;
+    int _value;
+    bool _pending;
+    bool _pendingIsSub;
+    uchar _prefix;
+    uchar _intermediates[IntermediateCapacity];
+    int _intermediateCount;
+    bool _overflowed;
+    bool _valid;
+};
+
+}   // namespace Connection
+
+}   // namespace UJ
+
+#endif // CSIPARAMETERS_H
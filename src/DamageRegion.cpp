@@ -0,0 +1,143 @@
+/*****************************************************************************
+ * DamageRegion.cpp
+ *
+ * Created: 16/10 2026 by uranusjr
+ *
+ * Copyright 2026 uranusjr. All rights reserved.
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ *****************************************************************************/
+
+#include "DamageRegion.h"
+#include <QRect>
+#include <qmath.h>
+
+namespace UJ
+{
+
+namespace Qelly
+{
+
+namespace
+{
+
+inline int area(const QRect &r)
+{
+    return r.width() * r.height();
+}
+
+}   // namespace
+
+DamageRegion::DamageRegion() :
+    _columns(0), _cellWidth(0), _cellHeight(0), _empty(true)
+{
+}
+
+void DamageRegion::setGrid(int rows, int columns,
+                           double cellWidth, double cellHeight)
+{
+    _columns = columns;
+    _cellWidth = cellWidth;
+    _cellHeight = cellHeight;
+    _begins.fill(columns, rows);
+    _ends.fill(0, rows);
+    _empty = true;
+}
+
+void DamageRegion::addCells(int row, int begin, int end)
+{
+    if (row < 0 || row >= _begins.size())
+        return;
+    begin = qMax(begin, 0);
+    end = qMin(end, _columns);
+    if (begin >= end)
+        return;
+    if (begin < _begins[row])
+        _begins[row] = begin;
+    if (end > _ends[row])
+        _ends[row] = end;
+    _empty = false;
+}
+
+void DamageRegion::addRows(int row, int count)
+{
+    for (int y = row; y < row + count; y++)
+        addCells(y, 0, _columns);
+}
+
+void DamageRegion::addAll()
+{
+    addRows(0, _begins.size());
+}
+
+QRegion DamageRegion::takeRegion()
+{
+    if (_empty)
+        return QRegion();
+
+    // Rectangles in cells, top to bottom
+    QVector<QRect> rects;
+    for (int y = 0; y < _begins.size(); y++)
+    {
+        int begin = _begins[y];
+        int end = _ends[y];
+        if (begin >= end)
+            continue;
+        if (!rects.isEmpty())
+        {
+            QRect &last = rects.last();
+            if (last.bottom() == y - 1
+                    && last.left() == begin && last.right() == end - 1)
+            {
+                last.setBottom(y);
+                continue;
+            }
+        }
+        rects.append(QRect(begin, y, end - begin, 1));
+    }
+    _begins.fill(_columns);
+    _ends.fill(0);
+    _empty = true;
+
+    while (rects.size() > MaxRectCount)
+    {
+        int best = 0;
+        int bestWaste = -1;
+        for (int i = 0; i + 1 < rects.size(); i++)
+        {
+            int waste = area(rects[i] | rects[i + 1])
+                    - area(rects[i]) - area(rects[i + 1]);
+            if (bestWaste < 0 || waste < bestWaste)
+            {
+                best = i;
+                bestWaste = waste;
+            }
+        }
+        rects[best] |= rects[best + 1];
+        rects.remove(best + 1);
+    }
+
+    QRegion region;
+    for (int i = 0; i < rects.size(); i++)
+    {
+        const QRect &r = rects[i];
+        int left = int(r.left() * _cellWidth);
+        int top = int(r.top() * _cellHeight);
+        int right = qCeil((r.right() + 1) * _cellWidth);
+        int bottom = qCeil((r.bottom() + 1) * _cellHeight);
+        region += QRect(left, top, right - left, bottom - top);
+    }
+    return region;
+}
+
+}   // namespace Qelly
+
+}   // namespace UJ
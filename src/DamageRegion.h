@@ -0,0 +1,72 @@
+/*****************************************************************************
+ * DamageRegion.h
+ *
+ * Created: 16/10 2026 by uranusjr
+ *
+ * Copyright 2026 uranusjr. All rights reserved.
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ *****************************************************************************/
+
+#ifndef DAMAGEREGION_H
+#define DAMAGEREGION_H
+
+#include <QRegion>
+#include <QVector>
+
+namespace UJ
+{
+
+namespace Qelly
+{
+
+// The cells of a view that have to be repainted, collected as one span of
+// columns per row. Adding to it is cheap, so everything that changes the
+// screen adds what it touched here, and the view asks for a single repaint of
+// takeRegion() once it is done with a frame.
+//
+// takeRegion() joins rows sharing a span into one rectangle. If that still
+// leaves more than MaxRectCount of them, neighbouring rectangles are merged,
+// those that waste the least area first; repainting a few cells too many is
+// cheaper than walking a region with many small rectangles.
+class DamageRegion
+{
+public:
+    static const int MaxRectCount = 8;
+
+    DamageRegion();
+    void setGrid(int rows, int columns, double cellWidth, double cellHeight);
+
+    // Columns begin to end (exclusive) of the row; clipped to the grid
+    void addCells(int row, int begin, int end);
+    void addRows(int row, int count);
+    void addAll();
+
+    inline bool isEmpty() const
+    {
+        return _empty;
+    }
+    QRegion takeRegion();
+
+private:
+    QVector<int> _begins;
+    QVector<int> _ends;
+    int _columns;
+    double _cellWidth;
+    double _cellHeight;
+    bool _empty;
+};
+
+}   // namespace Qelly
+
+}   // namespace UJ
+
+#endif // DAMAGEREGION_H
@@ -0,0 +1,50 @@
+/*****************************************************************************
+ * DataSink.h
+ *
+ * Created: 16/10 2026 by uranusjr
+ *
+ * Copyright 2026 uranusjr. All rights reserved.
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ *****************************************************************************/
+
+#ifndef DATASINK_H
+#define DATASINK_H
+
+#include <QByteArray>
+
+namespace UJ
+{
+
+namespace Connection
+{
+
+// Where a connection hands the data it received, once the protocol has been
+// taken out of it. The connection calls it directly on its own thread:
+// receiveData() for each chunk, then endBatch() once after every run of
+// chunks that arrived together, which is when a sink should start acting on
+// them.
+class DataSink
+{
+public:
+    virtual ~DataSink()
+    {
+    }
+
+    virtual void receiveData(const QByteArray &bytes) = 0;
+    virtual void endBatch() = 0;
+};
+
+}   // namespace Connection
+
+}   // namespace UJ
+
+#endif // DATASINK_H
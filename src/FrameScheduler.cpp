@@ -0,0 +1,86 @@
+/*****************************************************************************
+ * FrameScheduler.cpp
+ *
+ * Created: 16/10 2026 by uranusjr
+ *
+ * Copyright 2026 uranusjr. All rights reserved.
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ *****************************************************************************/
+
+#include "FrameScheduler.h"
+#include <QTimer>
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+    #include <QGuiApplication>
+    #include <QScreen>
+#endif
+
+namespace UJ
+{
+
+namespace Qelly
+{
+
+namespace
+{
+
+int displayFrameInterval()
+{
+    qreal rate = 60;
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+    QScreen *screen = QGuiApplication::primaryScreen();
+    if (screen && screen->refreshRate() >= 1)
+        rate = screen->refreshRate();
+#endif
+    return qMax(1, qRound(1000 / rate));
+}
+
+}   // namespace
+
+FrameScheduler::FrameScheduler(QObject *parent) :
+    QObject(parent), _latencyBudget(2), _batchesProcessed(0),
+    _framesRendered(0)
+{
+    _frameInterval = displayFrameInterval();
+    _timer = new QTimer(this);
+    _timer->setSingleShot(true);
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+    _timer->setTimerType(Qt::PreciseTimer);   // The budget is a few msecs
+#endif
+    connect(_timer, SIGNAL(timeout()), this, SLOT(renderFrame()));
+    _clock.start();
+    _lastFrame = -_frameInterval;
+}
+
+void FrameScheduler::scheduleFrame()
+{
+    _batchesProcessed++;
+    if (_timer->isActive())
+        return;
+
+    qint64 now = _clock.elapsed();
+    qint64 next = _lastFrame + _frameInterval;
+    if (next <= now)
+        _timer->start(_latencyBudget);
+    else
+        _timer->start(qMax<qint64>(next - now, _latencyBudget));
+}
+
+void FrameScheduler::renderFrame()
+{
+    _lastFrame = _clock.elapsed();
+    _framesRendered++;
+    emit frameDue();
+}
+
+}   // namespace Qelly
+
+}   // namespace UJ
@@ -0,0 +1,113 @@
+/*****************************************************************************
+ * FrameScheduler.h
+ *
+ * Created: 16/10 2026 by uranusjr
+ *
+ * Copyright 2026 uranusjr. All rights reserved.
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ *****************************************************************************/
+
+#ifndef FRAMESCHEDULER_H
+#define FRAMESCHEDULER_H
+
+#include <QObject>
+#include <QElapsedTimer>
+class QTimer;
+
+namespace UJ
+{
+
+namespace Qelly
+{
+
+// Decides when a view renders what the terminal has parsed. The terminal
+// parses on a worker, and publishes a snapshot and calls scheduleFrame()
+// (through dataProcessed()) once for each batch it has parsed, a batch being
+// whatever the connection had read by the time the worker got to it. During
+// a burst that is far more often than the display refreshes, and rendering
+// every batch would draw back images that never reach the screen.
+//
+// Instead a frame is only asked for with frameDue():
+//  - If nothing was rendered for a whole frame interval, the frame follows
+//    the latency budget after the batch. This is what keystroke echo hits,
+//    and the budget lets the rest of a reply that is still being parsed go
+//    with it.
+//  - Otherwise the frame waits until a frame interval after the previous one,
+//    so a burst of data is drawn at most once per display refresh.
+// Every batch published while a frame is pending goes into that frame; the
+// view takes only the latest snapshot, with the changes of the ones before
+// merged in.
+class FrameScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit FrameScheduler(QObject *parent = 0);
+
+    inline int latencyBudget() const
+    {
+        return _latencyBudget;
+    }
+    inline void setLatencyBudget(int msecs)
+    {
+        _latencyBudget = msecs;
+    }
+    inline int frameInterval() const
+    {
+        return _frameInterval;
+    }
+    inline void setFrameInterval(int msecs)
+    {
+        _frameInterval = msecs;
+    }
+
+    // How much work the scheduler saved: batches parsed against frames
+    // actually rendered for them. AbstractConnection::chunksReceived() says
+    // how many reads went into the batches.
+    inline qint64 batchesProcessed() const
+    {
+        return _batchesProcessed;
+    }
+    inline qint64 framesRendered() const
+    {
+        return _framesRendered;
+    }
+    inline void resetCounters()
+    {
+        _batchesProcessed = 0;
+        _framesRendered = 0;
+    }
+
+signals:
+    void frameDue();
+
+public slots:
+    void scheduleFrame();
+
+private slots:
+    void renderFrame();
+
+private:
+    QTimer *_timer;
+    QElapsedTimer _clock;
+    qint64 _lastFrame;
+    int _latencyBudget;
+    int _frameInterval;
+    qint64 _batchesProcessed;
+    qint64 _framesRendered;
+};
+
+}   // namespace Qelly
+
+}   // namespace UJ
+
+#endif // FRAMESCHEDULER_H
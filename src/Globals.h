@@ -67,6 +67,7 @@ enum Type
 {
     TypeTelnet,
     TypeSsh,
+    TypeReplay,
     TypeUnknown
 };
 
@@ -113,7 +114,7 @@ union CellAttribute
         uint reversed       : 1;
         uint doubleByte     : 2;
         uint isUrl          : 1;
-        uint isNothing      : 1;
+        uint isGraphic      : 1;    // Printed in DEC Special Graphics
     } f;
 };
 
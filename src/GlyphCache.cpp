@@ -0,0 +1,572 @@
+/*****************************************************************************
+ * GlyphCache.cpp
+ *
+ * Created: 16/10 2026 by uranusjr
+ *
+ * Copyright 2026 uranusjr. All rights reserved.
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ *****************************************************************************/
+
+#include "GlyphCache.h"
+#include <algorithm>
+#include <cstring>
+#include <QAtomicInt>
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFontDatabase>
+#include <QImage>
+#include <QPainter>
+#include <QThread>
+#include "BlockGlyphs.h"
+
+namespace UJ
+{
+
+namespace Qelly
+{
+
+namespace
+{
+
+// Layout of a mask file, in native byte order since the file never leaves
+// the machine that wrote it:
+//
+//  - Header
+//  - The style description, padded to a multiple of 4 bytes
+//  - The sorted character codes, padded to a multiple of 4 bytes
+//  - One mask per code, in the same order
+//
+// Changing the layout or the way masks are rasterized needs a new version.
+const char FileMagic[8] = {'Q', 'E', 'L', 'L', 'Y', 'G', 'L', 'Y'};
+const quint32 FileVersion = 1;
+
+struct FileHeader
+{
+    char magic[8];
+    quint32 version;
+    quint32 width;
+    quint32 height;
+    quint32 descriptionSize;
+    quint32 count;
+};
+
+inline int padded(int size)
+{
+    return (size + 3) & ~3;
+}
+
+inline int maskStride(const QSize &size)
+{
+    return padded(size.width());
+}
+
+inline int maskSize(const QSize &size)
+{
+    return maskStride(size) * size.height();
+}
+
+// Coverage of the character drawn with the font, one byte per pixel. Only
+// touches a QImage, so this is safe to run off the GUI thread.
+QByteArray rasterize(const QFont &font, const QSize &size,
+                     const QPoint &origin, ushort code)
+{
+    QImage image(size, QImage::Format_ARGB32_Premultiplied);
+    image.fill(0);
+    QPainter painter(&image);
+    painter.setFont(font);
+    painter.setPen(Qt::white);
+    painter.drawText(origin, QString(QChar(code)));
+    painter.end();
+
+    int stride = maskStride(size);
+    QByteArray mask(maskSize(size), '\0');
+    uchar *data = reinterpret_cast<uchar *>(mask.data());
+    for (int y = 0; y < size.height(); y++)
+    {
+        const QRgb *line = reinterpret_cast<const QRgb *>(image.scanLine(y));
+        for (int x = 0; x < size.width(); x++)
+            data[y * stride + x] = qAlpha(line[x]);
+    }
+    return mask;
+}
+
+}   // namespace
+
+// Rasterizes masks for a list of characters, at the lowest priority so that
+// it never competes with the GUI thread.
+class GlyphWarmUp : public QThread
+{
+public:
+    GlyphWarmUp(int style, const QFont &font, const QSize &size,
+                const QPoint &origin, const QVector<ushort> &codes,
+                QObject *parent) :
+        QThread(parent), style(style), font(font), size(size),
+        origin(origin), codes(codes), _stopped(0)
+    {
+    }
+
+    inline void stop()
+    {
+        _stopped.fetchAndStoreOrdered(1);
+    }
+
+    const int style;
+    const QFont font;
+    const QSize size;
+    const QPoint origin;
+    const QVector<ushort> codes;
+    QHash<ushort, QByteArray> masks;
+
+protected:
+    virtual void run()
+    {
+        for (int i = 0; i < codes.size(); i++)
+        {
+            if (_stopped.fetchAndAddOrdered(0))
+                break;
+            masks.insert(codes.at(i), rasterize(font, size, origin,
+                                                codes.at(i)));
+        }
+    }
+
+private:
+    QAtomicInt _stopped;
+};
+
+GlyphCache::GlyphCache(QObject *parent) :
+    QObject(parent), _glyphs(DefaultMemoryLimit),
+    _glyphImages(DefaultMemoryLimit), _tiles(DefaultMemoryLimit / 4),
+    _tileImages(DefaultMemoryLimit / 4)
+{
+    _warmUp = 0;
+    if (QCoreApplication::instance())
+    {
+        connect(QCoreApplication::instance(), SIGNAL(aboutToQuit()),
+                this, SLOT(shutDown()));
+    }
+}
+
+GlyphCache::~GlyphCache()
+{
+    shutDown();
+    for (int i = 0; i < _styles.size(); i++)
+    {
+        unmap(_styles.at(i));
+        delete _styles.at(i);
+    }
+}
+
+int GlyphCache::style(const QFont &font, const QSize &size,
+                      const QPoint &origin)
+{
+    for (int i = 0; i < _styles.size(); i++)
+    {
+        const Style *s = _styles.at(i);
+        if (s->font == font && s->size == size && s->origin == origin)
+            return i;
+    }
+    Style *s = new Style();
+    s->font = font;
+    s->size = size;
+    s->origin = origin;
+    // Everything that changes how a mask looks goes into the description,
+    // which names the file the masks are kept in
+    s->description = QString("%1|%2|%3x%4|%5,%6").arg(font.toString())
+            .arg(font.styleStrategy()).arg(size.width()).arg(size.height())
+            .arg(origin.x()).arg(origin.y());
+    s->file = 0;
+    s->mappedCodes = 0;
+    s->mappedMasks = 0;
+    s->mappedCount = 0;
+    s->changed = false;
+    s->warmedUp = false;
+    _styles << s;
+    load(s);
+    return _styles.size() - 1;
+}
+
+QPixmap GlyphCache::glyph(int style, ushort code, QRgb color)
+{
+    quint64 key = glyphKey(style, code, color);
+    QPixmap *cached = _glyphs.object(key);
+    if (cached)
+        return *cached;
+
+    const QSize &size = _styles.at(style)->size;
+    QPixmap *pixmap = new QPixmap(QPixmap::fromImage(
+                                      colorize(style, code, color)));
+    QPixmap result = *pixmap;
+    _glyphs.insert(key, pixmap, size.width() * size.height() * 4);
+    return result;
+}
+
+QImage GlyphCache::glyphImage(int style, ushort code, QRgb color)
+{
+    quint64 key = glyphKey(style, code, color);
+    QImage *cached = _glyphImages.object(key);
+    if (cached)
+        return *cached;
+
+    const QSize &size = _styles.at(style)->size;
+    QImage *image = new QImage(colorize(style, code, color));
+    QImage result = *image;
+    _glyphImages.insert(key, image, size.width() * size.height() * 4);
+    return result;
+}
+
+QPixmap GlyphCache::tile(ushort code, const QSize &size, QRgb left,
+                         QRgb right)
+{
+    TileKey key = {code, size, left, right};
+    QPixmap *cached = _tiles.object(key);
+    if (cached)
+        return *cached;
+
+    QPixmap *pixmap = new QPixmap(QPixmap::fromImage(
+                                      drawTile(code, size, left, right)));
+    QPixmap result = *pixmap;
+    _tiles.insert(key, pixmap, size.width() * size.height() * 4);
+    return result;
+}
+
+QImage GlyphCache::tileImage(ushort code, const QSize &size, QRgb left,
+                             QRgb right)
+{
+    TileKey key = {code, size, left, right};
+    QImage *cached = _tileImages.object(key);
+    if (cached)
+        return *cached;
+
+    QImage *image = new QImage(drawTile(code, size, left, right));
+    QImage result = *image;
+    _tileImages.insert(key, image, size.width() * size.height() * 4);
+    return result;
+}
+
+quint64 GlyphCache::glyphKey(int style, ushort code, QRgb color)
+{
+    // 24 bits of color, 16 of character and the rest for the style
+    return (quint64(style) << 40) | (quint64(code) << 24) |
+           (color & 0xffffff);
+}
+
+QImage GlyphCache::colorize(int style, ushort code, QRgb color)
+{
+    Style *s = _styles.at(style);
+    const uchar *coverage = mask(s, code);
+    int stride = maskStride(s->size);
+    QImage image(s->size, QImage::Format_ARGB32_Premultiplied);
+    for (int y = 0; y < s->size.height(); y++)
+    {
+        QRgb *line = reinterpret_cast<QRgb *>(image.scanLine(y));
+        const uchar *m = coverage + y * stride;
+        for (int x = 0; x < s->size.width(); x++)
+        {
+            int a = m[x];
+            line[x] = qRgba(qRed(color) * a / 255, qGreen(color) * a / 255,
+                            qBlue(color) * a / 255, a);
+        }
+    }
+    return image;
+}
+
+QImage GlyphCache::drawTile(ushort code, const QSize &size, QRgb left,
+                            QRgb right)
+{
+    QImage image(size, QImage::Format_ARGB32_Premultiplied);
+    image.fill(0);
+    QPainter painter(&image);
+    QRect rect(QPoint(0, 0), size);
+    if (left == right)
+    {
+        drawBlockGlyph(&painter, code, rect, QColor(left));
+    }
+    else
+    {
+        // The whole character in each color, each kept to its own cell
+        int half = size.width() / 2;
+        painter.setClipRect(0, 0, half, size.height());
+        drawBlockGlyph(&painter, code, rect, QColor(left));
+        painter.setClipRect(half, 0, size.width() - half, size.height());
+        drawBlockGlyph(&painter, code, rect, QColor(right));
+    }
+    painter.end();
+    return image;
+}
+
+void GlyphCache::warmUp(int style, const QVector<ushort> &codes)
+{
+    Style *s = _styles.at(style);
+    if (s->warmedUp || _warmUp)
+        return;
+    if (!QFontDatabase::supportsThreadedFontRendering())
+        return;
+    s->warmedUp = true;
+
+    // Masks loaded from disk need no work; on later runs there is usually
+    // nothing left, and no thread is started at all
+    QVector<ushort> missing;
+    for (int i = 0; i < codes.size(); i++)
+    {
+        ushort code = codes.at(i);
+        if (!s->masks.contains(code) && !mappedMask(s, code))
+            missing << code;
+    }
+    if (missing.isEmpty())
+        return;
+
+    _warmUp = new GlyphWarmUp(style, s->font, s->size, s->origin, missing,
+                              this);
+    connect(_warmUp, SIGNAL(finished()), this, SLOT(finishWarmUp()));
+    _warmUp->start(QThread::LowestPriority);
+}
+
+void GlyphCache::clear()
+{
+    _glyphs.clear();
+    _glyphImages.clear();
+    _tiles.clear();
+    _tileImages.clear();
+}
+
+void GlyphCache::setDiskCacheDirectory(const QString &path)
+{
+    if (path == _directory)
+        return;
+    save();
+    _directory = path;
+    for (int i = 0; i < _styles.size(); i++)
+    {
+        Style *s = _styles.at(i);
+        unmap(s);
+        load(s);
+        s->changed = !s->masks.isEmpty();
+    }
+}
+
+void GlyphCache::save()
+{
+    for (int i = 0; i < _styles.size(); i++)
+    {
+        Style *s = _styles.at(i);
+        if (s->changed && save(s))
+            s->changed = false;
+    }
+}
+
+void GlyphCache::finishWarmUp()
+{
+    // Already taken care of if the thread was stopped by shutDown()
+    if (!_warmUp)
+        return;
+    Style *s = _styles.at(_warmUp->style);
+    QHash<ushort, QByteArray>::const_iterator it = _warmUp->masks.constBegin();
+    for (; it != _warmUp->masks.constEnd(); ++it)
+    {
+        if (!s->masks.contains(it.key()) && !mappedMask(s, it.key()))
+        {
+            s->masks.insert(it.key(), it.value());
+            s->changed = true;
+        }
+    }
+    _warmUp->deleteLater();
+    _warmUp = 0;
+    save();
+}
+
+void GlyphCache::shutDown()
+{
+    if (_warmUp)
+    {
+        _warmUp->stop();
+        _warmUp->wait();
+        finishWarmUp();
+    }
+    else
+    {
+        save();
+    }
+}
+
+const uchar *GlyphCache::mask(Style *s, ushort code)
+{
+    const uchar *mapped = mappedMask(s, code);
+    if (mapped)
+        return mapped;
+    QHash<ushort, QByteArray>::iterator it = s->masks.find(code);
+    if (it == s->masks.end())
+    {
+        it = s->masks.insert(code, rasterize(s->font, s->size, s->origin,
+                                             code));
+        s->changed = true;
+    }
+    return reinterpret_cast<const uchar *>(it.value().constData());
+}
+
+const uchar *GlyphCache::mappedMask(const Style *s, ushort code) const
+{
+    const ushort *end = s->mappedCodes + s->mappedCount;
+    const ushort *found = std::lower_bound(s->mappedCodes, end, code);
+    if (found == end || *found != code)
+        return 0;
+    return s->mappedMasks + (found - s->mappedCodes) * maskSize(s->size);
+}
+
+void GlyphCache::load(Style *s)
+{
+    if (_directory.isEmpty())
+        return;
+    QFile *file = new QFile(fileName(s));
+    if (!file->open(QIODevice::ReadOnly))
+    {
+        delete file;
+        return;
+    }
+
+    // Anything that does not look exactly right is ignored, and replaced by
+    // the next save
+    QByteArray description = s->description.toUtf8();
+    const uchar *data = file->map(0, file->size());
+    qint64 size = data ? file->size() : 0;
+    const FileHeader *header = reinterpret_cast<const FileHeader *>(data);
+    qint64 codesOffset = sizeof(FileHeader) + padded(description.size());
+    if (size < codesOffset
+            || memcmp(header->magic, FileMagic, sizeof(FileMagic))
+            || header->version != FileVersion
+            || int(header->width) != s->size.width()
+            || int(header->height) != s->size.height()
+            || int(header->descriptionSize) != description.size()
+            || memcmp(data + sizeof(FileHeader), description.constData(),
+                      description.size()))
+    {
+        delete file;
+        return;
+    }
+    int count = header->count;
+    qint64 masksOffset = codesOffset + padded(count * sizeof(ushort));
+    if (size < masksOffset + qint64(count) * maskSize(s->size))
+    {
+        delete file;
+        return;
+    }
+
+    s->file = file;
+    s->mappedCodes = reinterpret_cast<const ushort *>(data + codesOffset);
+    s->mappedMasks = data + masksOffset;
+    s->mappedCount = count;
+}
+
+bool GlyphCache::save(Style *s)
+{
+    if (_directory.isEmpty() || !QDir().mkpath(_directory))
+        return false;
+
+    // Both the mapped masks and the new ones, merged in code order
+    QVector<ushort> codes;
+    codes.reserve(s->mappedCount + s->masks.size());
+    for (int i = 0; i < s->mappedCount; i++)
+        codes << s->mappedCodes[i];
+    QHash<ushort, QByteArray>::const_iterator it = s->masks.constBegin();
+    for (; it != s->masks.constEnd(); ++it)
+    {
+        if (!mappedMask(s, it.key()))
+            codes << it.key();
+    }
+    std::sort(codes.begin(), codes.end());
+
+    QByteArray description = s->description.toUtf8();
+    FileHeader header;
+    memcpy(header.magic, FileMagic, sizeof(FileMagic));
+    header.version = FileVersion;
+    header.width = s->size.width();
+    header.height = s->size.height();
+    header.descriptionSize = description.size();
+    header.count = codes.size();
+    QByteArray padding(3, '\0');
+
+    // Written next to the old file and renamed over it, so a crash never
+    // leaves a half-written cache behind
+    QString name = fileName(s);
+    QFile file(name + ".tmp");
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(description);
+    file.write(padding.constData(),
+               padded(description.size()) - description.size());
+    int codesSize = codes.size() * sizeof(ushort);
+    file.write(reinterpret_cast<const char *>(codes.constData()), codesSize);
+    file.write(padding.constData(), padded(codesSize) - codesSize);
+    for (int i = 0; i < codes.size(); i++)
+    {
+        const uchar *m = mask(s, codes.at(i));
+        file.write(reinterpret_cast<const char *>(m), maskSize(s->size));
+    }
+    if (file.error() != QFile::NoError)
+    {
+        file.remove();
+        return false;
+    }
+    file.close();
+
+    unmap(s);
+    QFile::remove(name);
+    if (!file.rename(name))
+    {
+        file.remove();
+        return false;
+    }
+    // Everything is on disk now; map it back instead of keeping copies
+    load(s);
+    if (s->file)
+        s->masks.clear();
+    return true;
+}
+
+void GlyphCache::unmap(Style *s)
+{
+    if (!s->file)
+        return;
+    // The mapped masks go away with the file; keep them around as copies
+    for (int i = 0; i < s->mappedCount; i++)
+    {
+        const uchar *m = s->mappedMasks + i * maskSize(s->size);
+        s->masks.insert(s->mappedCodes[i],
+                        QByteArray(reinterpret_cast<const char *>(m),
+                                   maskSize(s->size)));
+    }
+    s->mappedCodes = 0;
+    s->mappedMasks = 0;
+    s->mappedCount = 0;
+    delete s->file;
+    s->file = 0;
+}
+
+QString GlyphCache::fileName(const Style *s) const
+{
+    QString name = QString("glyphs-%1-%2.cache").arg(FileVersion)
+            .arg(qHash(s->description), 8, 16, QChar('0'));
+    return QDir(_directory).filePath(name);
+}
+
+uint qHash(const GlyphCache::TileKey &key)
+{
+    quint64 shape = (quint64(key.code) << 32) | (key.size.width() << 16)
+            | key.size.height();
+    quint64 colors = (quint64(key.left) << 32) | key.right;
+    return ::qHash(shape) ^ ::qHash(colors);
+}
+
+}   // namespace Qelly
+
+}   // namespace UJ
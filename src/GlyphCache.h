@@ -0,0 +1,174 @@
+/*****************************************************************************
+ * GlyphCache.h
+ *
+ * Created: 16/10 2026 by uranusjr
+ *
+ * Copyright 2026 uranusjr. All rights reserved.
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ *****************************************************************************/
+
+#ifndef GLYPHCACHE_H
+#define GLYPHCACHE_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QCache>
+#include <QFont>
+#include <QHash>
+#include <QImage>
+#include <QList>
+#include <QPixmap>
+#include <QPoint>
+#include <QSize>
+#include <QString>
+#include <QVector>
+class QFile;
+
+namespace UJ
+{
+
+namespace Qelly
+{
+
+class GlyphWarmUp;
+
+// Rendered glyphs, shared by every view in the process. A glyph is drawn
+// once per (style, character, color) into a pixmap with a transparent
+// background, and drawn again from there. The least recently used glyphs are
+// dropped when the cache grows over its memory limit.
+//
+// A style is a font together with the box a glyph is drawn into and the
+// baseline origin inside that box. Views register the styles they draw with
+// and keep the ids; registering the same style again returns the same id, so
+// views with identical settings share glyphs.
+//
+// Underneath the colored glyphs are coverage masks, one per character and
+// style, which is what rasterizing a font actually costs. With a disk cache
+// directory set, the masks of each style are saved there and memory-mapped
+// the next time the style is registered. warmUp() rasterizes masks on a
+// low-priority thread ahead of time.
+//
+// Block glyphs (see BlockGlyphs.h) are drawn as tiles instead, one per
+// character, size and pair of colors: the left cell of a double-byte tile
+// takes the first color, and the right one the second.
+//
+// glyphImage() and tileImage() are the same as QImage, for drawing onto a
+// raster back buffer, which may happen off the GUI thread where pixmaps
+// cannot go. They are cached apart from the pixmaps.
+class GlyphCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    static const int DefaultMemoryLimit = 16 * 1024 * 1024;
+
+    static inline GlyphCache *sharedInstance()
+    {
+        static GlyphCache *g = new GlyphCache();
+        return g;
+    }
+
+    explicit GlyphCache(QObject *parent = 0);
+    virtual ~GlyphCache();
+    int style(const QFont &font, const QSize &size, const QPoint &origin);
+    QPixmap glyph(int style, ushort code, QRgb color);
+    QPixmap tile(ushort code, const QSize &size, QRgb left, QRgb right);
+    QImage glyphImage(int style, ushort code, QRgb color);
+    QImage tileImage(ushort code, const QSize &size, QRgb left, QRgb right);
+    void warmUp(int style, const QVector<ushort> &codes);
+    void clear();
+
+    inline int memoryLimit() const
+    {
+        return _glyphs.maxCost();
+    }
+    inline void setMemoryLimit(int bytes)
+    {
+        _glyphs.setMaxCost(bytes);
+        _glyphImages.setMaxCost(bytes);
+        _tiles.setMaxCost(bytes / 4);
+        _tileImages.setMaxCost(bytes / 4);
+    }
+    inline int memoryUsed() const
+    {
+        return _glyphs.totalCost() + _glyphImages.totalCost()
+                + _tiles.totalCost() + _tileImages.totalCost();
+    }
+    inline QString diskCacheDirectory() const
+    {
+        return _directory;
+    }
+    void setDiskCacheDirectory(const QString &path);
+
+public slots:
+    void save();
+
+private slots:
+    void finishWarmUp();
+    void shutDown();
+
+private:
+    struct Style
+    {
+        QFont font;
+        QSize size;
+        QPoint origin;
+        QString description;
+        QFile *file;                    // Masks saved by an earlier run
+        const ushort *mappedCodes;
+        const uchar *mappedMasks;
+        int mappedCount;
+        QHash<ushort, QByteArray> masks;    // Masks rasterized in this run
+        bool changed;
+        bool warmedUp;
+    };
+
+    static quint64 glyphKey(int style, ushort code, QRgb color);
+    QImage colorize(int style, ushort code, QRgb color);
+    static QImage drawTile(ushort code, const QSize &size, QRgb left,
+                           QRgb right);
+    const uchar *mask(Style *s, ushort code);
+    const uchar *mappedMask(const Style *s, ushort code) const;
+    void load(Style *s);
+    bool save(Style *s);
+    void unmap(Style *s);
+    QString fileName(const Style *s) const;
+
+    struct TileKey
+    {
+        ushort code;
+        QSize size;
+        QRgb left;
+        QRgb right;
+
+        inline bool operator==(const TileKey &other) const
+        {
+            return code == other.code && size == other.size
+                    && left == other.left && right == other.right;
+        }
+    };
+    friend uint qHash(const TileKey &key);
+
+    QList<Style *> _styles;
+    QCache<quint64, QPixmap> _glyphs;
+    QCache<quint64, QImage> _glyphImages;
+    QCache<TileKey, QPixmap> _tiles;
+    QCache<TileKey, QImage> _tileImages;
+    QString _directory;
+    GlyphWarmUp *_warmUp;
+};
+
+}   // namespace Qelly
+
+}   // namespace UJ
+
+#endif // GLYPHCACHE_H
@@ -0,0 +1,235 @@
+/*****************************************************************************
+ * IoChannel.cpp
+ *
+ * Created: 16/10 2026 by uranusjr
+ *
+ * Copyright 2026 uranusjr. All rights reserved.
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ *****************************************************************************/
+
+#include "IoChannel.h"
+#include <QAbstractSocket>
+#include <QProcess>
+#include <QThread>
+
+namespace UJ
+{
+
+namespace Connection
+{
+
+namespace
+{
+
+// The reactor. Its event loop waits on every connection's descriptors at
+// once, with whatever the platform's event dispatcher polls them with.
+QThread *reactorThread()
+{
+    static QThread *thread = 0;
+    if (!thread)
+    {
+        thread = new QThread();
+        thread->setObjectName("I/O reactor");
+        thread->start(QThread::HighPriority);
+    }
+    return thread;
+}
+
+}   // namespace
+
+IoChannel::IoChannel(QIODevice *device) :
+    _device(device), _received(QueueSize), _sending(QueueSize),
+    _overflowing(0), _readablePending(0), _readStalled(0), _writePending(0)
+{
+    _device->setParent(this);
+    connect(_device, SIGNAL(readyRead()), this, SLOT(readDevice()));
+
+    // Forwarded without their arguments, so that none of them have to be
+    // registered to cross threads
+    if (qobject_cast<QAbstractSocket *>(_device))
+    {
+        connect(_device, SIGNAL(connected()), this, SIGNAL(opened()));
+        connect(_device, SIGNAL(disconnected()), this, SIGNAL(closed()));
+        connect(_device, SIGNAL(error(QAbstractSocket::SocketError)),
+                this, SIGNAL(failed()));
+    }
+    else if (qobject_cast<QProcess *>(_device))
+    {
+        connect(_device, SIGNAL(started()), this, SIGNAL(opened()));
+        connect(_device, SIGNAL(finished(int, QProcess::ExitStatus)),
+                this, SIGNAL(closed()));
+        connect(_device, SIGNAL(error(QProcess::ProcessError)),
+                this, SIGNAL(failed()));
+    }
+
+    moveToThread(reactorThread());
+}
+
+void IoChannel::connectToHost(const QString &address, int port)
+{
+    QMetaObject::invokeMethod(this, "openSocket", Qt::QueuedConnection,
+                              Q_ARG(QString, address), Q_ARG(int, port));
+}
+
+void IoChannel::start(const QString &program, const QStringList &arguments)
+{
+    QMetaObject::invokeMethod(this, "startProcess", Qt::QueuedConnection,
+                              Q_ARG(QString, program),
+                              Q_ARG(QStringList, arguments));
+}
+
+bool IoChannel::read(QByteArray *chunk)
+{
+    if (_received.pop(chunk))
+        return true;
+
+    // Drained; anything the reactor pushes from now on signals again. Look
+    // once more for a chunk pushed while readable() was still pending.
+    _readablePending.fetchAndStoreOrdered(0);
+    if (_received.pop(chunk))
+        return true;
+    if (_readStalled.testAndSetOrdered(1, 0))
+        QMetaObject::invokeMethod(this, "readDevice", Qt::QueuedConnection);
+    return false;
+}
+
+void IoChannel::write(const QByteArray &bytes)
+{
+    // The reactor may be held up by another connection, so a full queue
+    // spills over into a list instead of waiting for room. Once it has,
+    // everything goes to the list until the reactor has taken it, so the
+    // bytes still go out in order.
+    if (_overflowing.fetchAndAddAcquire(0) || !_sending.push(bytes))
+    {
+        QMutexLocker locker(&_overflowLock);
+        _overflow.append(bytes);
+        _overflowing.fetchAndStoreRelease(1);
+    }
+    if (_writePending.testAndSetOrdered(0, 1))
+        QMetaObject::invokeMethod(this, "writeDevice", Qt::QueuedConnection);
+}
+
+void IoChannel::release()
+{
+    QMetaObject::invokeMethod(this, "closeDevice", Qt::QueuedConnection);
+}
+
+void IoChannel::openSocket(const QString &address, int port)
+{
+    QAbstractSocket *socket = qobject_cast<QAbstractSocket *>(_device);
+    if (socket)
+        socket->connectToHost(address, port);
+}
+
+void IoChannel::startProcess(const QString &program,
+                             const QStringList &arguments)
+{
+    QProcess *process = qobject_cast<QProcess *>(_device);
+    if (process)
+        process->start(program, arguments);
+}
+
+void IoChannel::readDevice()
+{
+    bool pushed = false;
+    while (_device->bytesAvailable() > 0)
+    {
+        if (_received.isFull())
+        {
+            // Flag it before looking again, so that either the session sees
+            // the flag when it drains, or this sees the room it made
+            _readStalled.fetchAndStoreOrdered(1);
+            if (_received.isFull())
+                break;
+            _readStalled.fetchAndStoreOrdered(0);
+        }
+
+        // A burst comes in a few large chunks, and a keystroke echo still
+        // in one small one
+        int size = static_cast<int>(
+                    qMin<qint64>(_device->bytesAvailable(), MaxChunkSize));
+        QByteArray chunk = takePooledBuffer();
+        chunk.reserve(size);    // Keeps the buffer when resized below
+        chunk.resize(size);
+        qint64 length = _device->read(chunk.data(), size);
+        if (length > 0)
+        {
+            chunk.resize(length);
+            _received.push(chunk);
+            pushed = true;
+        }
+        if (_pool.size() < PoolSize)
+            _pool.append(chunk);
+        if (length <= 0)
+            break;
+    }
+    if (pushed && _readablePending.testAndSetOrdered(0, 1))
+        emit readable();
+}
+
+QByteArray IoChannel::takePooledBuffer()
+{
+    // Nobody else can take a reference to a buffer the pool holds the only
+    // one to, so once it is detached it stays free
+    for (int i = 0; i < _pool.size(); i++)
+    {
+        if (_pool.at(i).isDetached())
+            return _pool.takeAt(i);
+    }
+    return QByteArray();
+}
+
+void IoChannel::writeDevice()
+{
+    _writePending.fetchAndStoreOrdered(0);
+    QList<QByteArray> pending;
+    QByteArray bytes;
+    while (_sending.pop(&bytes))
+        pending.append(bytes);
+    if (_overflowing.fetchAndAddAcquire(0))
+    {
+        QMutexLocker locker(&_overflowLock);
+        pending.append(_overflow);
+        _overflow.clear();
+        _overflowing.fetchAndStoreRelease(0);
+    }
+
+    // Written in full; both sockets and processes buffer what the other end
+    // is not ready for yet
+    if (!_device->isOpen())
+        return;
+    for (int i = 0; i < pending.size(); i++)
+        _device->write(pending.at(i));
+}
+
+void IoChannel::closeDevice()
+{
+    // ~QProcess kills a running process and waits for it to exit, which
+    // would hold up every connection on the reactor. Kill it here instead,
+    // and go away when it is reported gone.
+    QProcess *process = qobject_cast<QProcess *>(_device);
+    if (process && process->state() != QProcess::NotRunning)
+    {
+        connect(process, SIGNAL(finished(int, QProcess::ExitStatus)),
+                this, SLOT(deleteLater()));
+        connect(process, SIGNAL(error(QProcess::ProcessError)),
+                this, SLOT(deleteLater()));
+        process->kill();
+        return;
+    }
+    _device->close();
+    deleteLater();
+}
+
+}   // namespace Connection
+
+}   // namespace UJ
@@ -0,0 +1,113 @@
+/*****************************************************************************
+ * IoChannel.h
+ *
+ * Created: 16/10 2026 by uranusjr
+ *
+ * Copyright 2026 uranusjr. All rights reserved.
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ *****************************************************************************/
+
+#ifndef IOCHANNEL_H
+#define IOCHANNEL_H
+
+#include <QByteArray>
+#include <QList>
+#include <QMutex>
+#include <QObject>
+#include <QStringList>
+#include "UJSpscQueue.h"
+class QIODevice;
+
+namespace UJ
+{
+
+namespace Connection
+{
+
+// A socket or pipe serviced on the I/O reactor, one thread shared by every
+// connection, so reading and writing never waits for painting or input on
+// the GUI thread, nor the other way round.
+//
+// The reactor reads whatever is available at once, up to a cap, into pooled
+// buffers, and pushes the chunks onto a queue the session pops on its own
+// thread; bytes to send travel the other way on a second queue. The pool
+// keeps a reference to every buffer it lends out, and a buffer is read into
+// again once that is the only one left, i.e. when the session and the
+// parser are both done with it. readable() is emitted once when chunks start
+// waiting, and not again until the session has found the queue empty, so a
+// busy connection costs one signal per batch instead of one per read. When
+// the session falls behind and the queue fills up, the reactor stops reading
+// from the device until it has caught up.
+//
+// A channel is never deleted directly but release()d: a process is killed
+// and the channel goes once it has exited, since ~QProcess would otherwise
+// block the reactor waiting for it.
+//
+// Everything except the signals and the private slots is called on the
+// session's thread.
+class IoChannel : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Takes over device, which must not have a parent yet, and moves them
+    // both to the reactor
+    explicit IoChannel(QIODevice *device);
+
+    void connectToHost(const QString &address, int port);
+    void start(const QString &program, const QStringList &arguments);
+
+    bool read(QByteArray *chunk);
+    void write(const QByteArray &bytes);
+
+    // Closes the device and deletes the channel on the reactor
+    void release();
+
+    // Each read takes what is available, up to this much
+    static const int MaxChunkSize = 64 * 1024;
+
+signals:
+    void opened();
+    void closed();
+    void failed();
+    void readable();
+
+private slots:
+    void openSocket(const QString &address, int port);
+    void startProcess(const QString &program, const QStringList &arguments);
+    void readDevice();
+    void writeDevice();
+    void closeDevice();
+
+private:
+    QByteArray takePooledBuffer();
+
+    static const int QueueSize = 64;
+    static const int PoolSize = 16;
+
+    QIODevice *_device;
+    SpscQueue<QByteArray> _received;    // Reactor to session
+    QList<QByteArray> _pool;            // Only used on the reactor
+    SpscQueue<QByteArray> _sending;     // Session to reactor
+    QMutex _overflowLock;
+    QList<QByteArray> _overflow;        // Sent after _sending when it fills up
+    QAtomicInt _overflowing;
+    QAtomicInt _readablePending;
+    QAtomicInt _readStalled;
+    QAtomicInt _writePending;
+};
+
+}   // namespace Connection
+
+}   // namespace UJ
+
+#endif // IOCHANNEL_H
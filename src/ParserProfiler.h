@@ -0,0 +1,181 @@
+/*****************************************************************************
+ * ParserProfiler.h
+ *
+ * Created: 16/10 2026 by uranusjr
+ *
+ * Copyright 2026 uranusjr. All rights reserved.
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ *****************************************************************************/
+
+#ifndef PARSERPROFILER_H
+#define PARSERPROFILER_H
+
+// Per-handler timing of Terminal's parser. Only compiled in when the build
+// defines QELLY_PARSER_PROFILING (the benchmark harness does); otherwise
+// PROFILE_PARSER() expands to nothing and the parser pays nothing for it.
+
+#ifdef QELLY_PARSER_PROFILING
+
+#include <QElapsedTimer>
+#include <QtGlobal>
+
+namespace UJ
+{
+
+namespace Connection
+{
+
+class ParserProfiler
+{
+public:
+    enum Handler
+    {
+        HandlerDispatch,
+        HandlerNormal,
+        HandlerPrint,
+        HandlerEscape,
+        HandlerCsiDispatch,
+        HandlerCup,
+        HandlerEd,
+        HandlerEl,
+        HandlerIl,
+        HandlerDl,
+        HandlerDch,
+        HandlerSgr,
+        HandlerMode,
+        HandlerDecstbm,
+        HandlerScroll,
+        HandlerClearRow,
+        HandlerDoubleByte,
+        HandlerUrl,
+        HandlerCount
+    };
+
+    // Time spent in nested scopes is charged to the innermost one only, so
+    // the totals of all handlers add up to the time spent in the parser.
+    explicit ParserProfiler(Handler handler)
+    {
+        _active = enabled();
+        if (!_active)
+            return;
+        _handler = handler;
+        _parent = current();
+        qint64 now = clock().nsecsElapsed();
+        if (_parent)
+            nsecs()[_parent->_handler] += now - _parent->_mark;
+        _mark = now;
+        current() = this;
+    }
+    ~ParserProfiler()
+    {
+        if (!_active)
+            return;
+        qint64 now = clock().nsecsElapsed();
+        nsecs()[_handler] += now - _mark;
+        calls()[_handler]++;
+        current() = _parent;
+        if (_parent)
+            _parent->_mark = now;
+    }
+
+    static inline bool &enabled()
+    {
+        static bool e = false;
+        return e;
+    }
+    static inline void setEnabled(bool enable)
+    {
+        if (enable)
+            clock().start();
+        enabled() = enable;
+    }
+    static inline void reset()
+    {
+        for (int i = 0; i < HandlerCount; i++)
+        {
+            nsecs()[i] = 0;
+            calls()[i] = 0;
+        }
+        cells() = 0;
+    }
+    static inline qint64 *nsecs()
+    {
+        static qint64 n[HandlerCount] = {0};
+        return n;
+    }
+    static inline qint64 *calls()
+    {
+        static qint64 c[HandlerCount] = {0};
+        return c;
+    }
+    // Cells written to the screen, however many calls it took
+    static inline qint64 &cells()
+    {
+        static qint64 c = 0;
+        return c;
+    }
+    static inline void addCells(int count)
+    {
+        if (enabled())
+            cells() += count;
+    }
+    static inline const char *name(int handler)
+    {
+        static const char *names[HandlerCount] = {
+            "processIncomingData", "handleNormalDataInput",
+            "setByteUnderCursor/setBytesUnderCursor", "handleEscapeDataInput",
+            "handleControlNonSimpleShiftingInputs",
+            "handleControlCup", "handleControlEd", "handleControlEl",
+            "handleControlIl", "handleControlDl", "handleControlDch",
+            "handleControlSgr", "handleControlSm/Rm", "handleControlDecstbm",
+            "scrollRows", "clearRow", "updateDoubleByteStateForRow",
+            "updateUrlStateForRow"
+        };
+        return names[handler];
+    }
+
+private:
+    static inline ParserProfiler *&current()
+    {
+        static ParserProfiler *c = 0;
+        return c;
+    }
+    static inline QElapsedTimer &clock()
+    {
+        static QElapsedTimer t;
+        return t;
+    }
+
+    bool _active;
+    Handler _handler;
+    ParserProfiler *_parent;
+    qint64 _mark;
+};
+
+}   // namespace Connection
+
+}   // namespace UJ
+
+#define PROFILE_PARSER(handler) \
+    UJ::Connection::ParserProfiler parserProfilerScope( \
+            UJ::Connection::ParserProfiler::handler)
+#define PROFILE_PARSER_CELLS(count) \
+    UJ::Connection::ParserProfiler::addCells(count)
+
+#else
+
+#define PROFILE_PARSER(handler)
+#define PROFILE_PARSER_CELLS(count)
+
+#endif // QELLY_PARSER_PROFILING
+
+#endif // PARSERPROFILER_H
@@ -0,0 +1,149 @@
+/*****************************************************************************
+ * RasterBackBuffer.cpp
+ *
+ * Created: 16/10 2026 by uranusjr
+ *
+ * Copyright 2026 uranusjr. All rights reserved.
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ *****************************************************************************/
+
+#include "RasterBackBuffer.h"
+#include <cstring>
+#include <QPainter>
+#include <QRunnable>
+#include <QThreadPool>
+
+namespace UJ
+{
+
+namespace Qelly
+{
+
+namespace
+{
+
+// Shared by all back buffers. Views render one at a time on the GUI thread,
+// so waiting for the pool only ever waits for strips of the same frame.
+QThreadPool *stripPool()
+{
+    static QThreadPool *pool = new QThreadPool();
+    return pool;
+}
+
+}   // namespace
+
+class RasterBackBuffer::StripRenderer : public QRunnable
+{
+public:
+    explicit StripRenderer(Strip *strip) : _strip(strip)
+    {
+    }
+
+    virtual void run()
+    {
+        RasterBackBuffer::render(_strip);
+    }
+
+private:
+    Strip *_strip;
+};
+
+RasterBackBuffer::RasterBackBuffer(const QSize &size, int stripHeight) :
+    _image(size, QImage::Format_RGB32), _stripHeight(qMax(stripHeight, 1))
+{
+    _image.fill(0);
+    int count = (size.height() + _stripHeight - 1) / _stripHeight;
+    _strips.resize(count);
+    for (int i = 0; i < count; i++)
+    {
+        // Views into the one image; they are never detached, since nothing
+        // ever copies the image while it is being drawn
+        Strip &strip = _strips[i];
+        strip.top = i * _stripHeight;
+        int height = qMin(_stripHeight, size.height() - strip.top);
+        strip.image = QImage(_image.scanLine(strip.top), size.width(),
+                             height, _image.bytesPerLine(), _image.format());
+    }
+}
+
+void RasterBackBuffer::fill(const QRect &rect, QRgb color)
+{
+    Operation operation;
+    operation.rect = rect;
+    operation.color = color;
+    stripAt(rect.top()).operations.append(operation);
+}
+
+void RasterBackBuffer::blit(const QPoint &point, const QImage &image,
+                            const QRect &source)
+{
+    Operation operation;
+    operation.source = source.isNull() ? image.rect() : source;
+    operation.rect = QRect(point, operation.source.size());
+    operation.image = image;
+    stripAt(point.y()).operations.append(operation);
+}
+
+void RasterBackBuffer::scroll(int top, int height, int offset)
+{
+    // Whatever was queued goes with the rows it was drawn on
+    render();
+    int bytesPerLine = _image.bytesPerLine();
+    std::memmove(_image.scanLine(top + offset), _image.scanLine(top),
+                 height * bytesPerLine);
+}
+
+void RasterBackBuffer::render()
+{
+    QVector<Strip *> pending;
+    for (int i = 0; i < _strips.size(); i++)
+    {
+        if (!_strips[i].operations.isEmpty())
+            pending.append(&_strips[i]);
+    }
+    if (pending.isEmpty())
+        return;
+
+    // The GUI thread takes a strip too instead of just waiting; a single
+    // strip, like the echo of a keystroke, never leaves it at all
+    QThreadPool *pool = stripPool();
+    for (int i = 1; i < pending.size(); i++)
+        pool->start(new StripRenderer(pending.at(i)));
+    render(pending.at(0));
+    if (pending.size() > 1)
+        pool->waitForDone();
+}
+
+void RasterBackBuffer::render(Strip *strip)
+{
+    QPainter painter(&strip->image);
+    painter.translate(0, -strip->top);
+    for (int i = 0; i < strip->operations.size(); i++)
+    {
+        const Operation &operation = strip->operations.at(i);
+        if (operation.image.isNull())
+        {
+            painter.fillRect(operation.rect, QColor(operation.color));
+        }
+        else
+        {
+            painter.drawImage(operation.rect.topLeft(), operation.image,
+                              operation.source);
+        }
+    }
+    painter.end();
+    strip->operations.resize(0);
+}
+
+}   // namespace Qelly
+
+}   // namespace UJ
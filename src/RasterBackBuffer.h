@@ -0,0 +1,89 @@
+/*****************************************************************************
+ * RasterBackBuffer.h
+ *
+ * Created: 16/10 2026 by uranusjr
+ *
+ * Copyright 2026 uranusjr. All rights reserved.
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ *****************************************************************************/
+
+#ifndef RASTERBACKBUFFER_H
+#define RASTERBACKBUFFER_H
+
+#include <QImage>
+#include <QRect>
+#include <QVector>
+
+namespace UJ
+{
+
+namespace Qelly
+{
+
+// A back image in client memory, drawn by several threads at once. The
+// image is cut into strips of whole rows, each a QImage of its own over the
+// same memory, so every strip can have its own painter.
+//
+// Drawing is recorded first: fill() and blit() only queue the operation on
+// the strip it falls in, and are called on the GUI thread, where the glyphs
+// come from. render() then draws the strips that have anything queued in
+// parallel, each in the order it was queued, and returns once all are done.
+// An operation must not cross a strip; cells never do.
+class RasterBackBuffer
+{
+public:
+    RasterBackBuffer(const QSize &size, int stripHeight);
+
+    inline const QImage &image() const
+    {
+        return _image;
+    }
+
+    void fill(const QRect &rect, QRgb color);
+    void blit(const QPoint &point, const QImage &image,
+              const QRect &source = QRect());
+    void scroll(int top, int height, int offset);
+    void render();
+
+private:
+    struct Operation
+    {
+        QRect rect;
+        QRgb color;
+        QImage image;       // Null for a fill
+        QRect source;
+    };
+
+    struct Strip
+    {
+        QImage image;
+        int top;
+        QVector<Operation> operations;
+    };
+
+    class StripRenderer;
+    static void render(Strip *strip);
+    inline Strip &stripAt(int y)
+    {
+        return _strips[y / _stripHeight];
+    }
+
+    QImage _image;
+    int _stripHeight;
+    QVector<Strip> _strips;
+};
+
+}   // namespace Qelly
+
+}   // namespace UJ
+
+#endif // RASTERBACKBUFFER_H
@@ -0,0 +1,54 @@
+/*****************************************************************************
+ * RenderSettings.cpp
+ *
+ * Created: 16/10 2026 by uranusjr
+ *
+ * Copyright 2026 uranusjr. All rights reserved.
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ *****************************************************************************/
+
+#include "RenderSettings.h"
+#include "SharedPreferences.h"
+
+namespace UJ
+{
+
+namespace Qelly
+{
+
+RenderSettings::RenderSettings(const SharedPreferences *prefs, int version)
+{
+    _version = version;
+    _cellWidth = prefs->cellWidth();
+    _cellHeight = prefs->cellHeight();
+    for (int bright = 0; bright < 2; bright++)
+    {
+        for (int i = 0; i < PaletteSize; i++)
+        {
+            _fColors[bright][i] = prefs->fColor(i, bright).rgb();
+            _bColors[bright][i] = prefs->bColor(i, bright).rgb();
+            _bBrushes[bright][i] = QBrush(QColor(_bColors[bright][i]));
+        }
+    }
+    _backgroundColor = prefs->backgroundColor();
+    _defaultFont = prefs->defaultFont();
+    _doubleByteFont = prefs->doubleByteFont();
+    _defaultFontPaddingLeft = prefs->defaultFontPaddingLeft();
+    _defaultFontPaddingBottom = prefs->defaultFontPaddingBottom();
+    _doubleByteFontPaddingLeft = prefs->doubleByteFontPaddingLeft();
+    _doubleByteFontPaddingBottom = prefs->doubleByteFontPaddingBottom();
+    _rasterBackBuffer = prefs->rasterBackBuffer();
+}
+
+}   // namespace Qelly
+
+}   // namespace UJ
@@ -0,0 +1,126 @@
+/*****************************************************************************
+ * RenderSettings.h
+ *
+ * Created: 16/10 2026 by uranusjr
+ *
+ * Copyright 2026 uranusjr. All rights reserved.
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ *****************************************************************************/
+
+#ifndef RENDERSETTINGS_H
+#define RENDERSETTINGS_H
+
+#include <QBrush>
+#include <QColor>
+#include <QFont>
+
+namespace UJ
+{
+
+namespace Qelly
+{
+
+class SharedPreferences;
+
+// Everything a view needs from the preferences to draw, read once. Reading
+// from SharedPreferences goes through QSettings every time, which is far too
+// slow to do per cell.
+//
+// A snapshot never changes after it is built. SharedPreferences builds a new
+// one, with a higher version, when the preferences window commits a change;
+// views hold on to theirs and switch to the new one between frames.
+class RenderSettings
+{
+public:
+    static const int PaletteSize = 16;
+
+    RenderSettings(const SharedPreferences *prefs, int version);
+
+    inline int version() const
+    {
+        return _version;
+    }
+    inline int cellWidth() const
+    {
+        return _cellWidth;
+    }
+    inline int cellHeight() const
+    {
+        return _cellHeight;
+    }
+    inline QRgb fColor(int index, bool bright = false) const
+    {
+        return _fColors[bright ? 1 : 0][index & (PaletteSize - 1)];
+    }
+    inline QRgb bColor(int index, bool bright = false) const
+    {
+        return _bColors[bright ? 1 : 0][index & (PaletteSize - 1)];
+    }
+    inline const QBrush &bBrush(int index, bool bright = false) const
+    {
+        return _bBrushes[bright ? 1 : 0][index & (PaletteSize - 1)];
+    }
+    inline QColor backgroundColor() const
+    {
+        return _backgroundColor;
+    }
+    inline const QFont &defaultFont() const
+    {
+        return _defaultFont;
+    }
+    inline const QFont &doubleByteFont() const
+    {
+        return _doubleByteFont;
+    }
+    inline bool rasterBackBuffer() const
+    {
+        return _rasterBackBuffer;
+    }
+    inline int defaultFontPaddingLeft() const
+    {
+        return _defaultFontPaddingLeft;
+    }
+    inline int defaultFontPaddingBottom() const
+    {
+        return _defaultFontPaddingBottom;
+    }
+    inline int doubleByteFontPaddingLeft() const
+    {
+        return _doubleByteFontPaddingLeft;
+    }
+    inline int doubleByteFontPaddingBottom() const
+    {
+        return _doubleByteFontPaddingBottom;
+    }
+
+private:
+    int _version;
+    int _cellWidth;
+    int _cellHeight;
+    QRgb _fColors[2][PaletteSize];
+    QRgb _bColors[2][PaletteSize];
+    QBrush _bBrushes[2][PaletteSize];
+    QColor _backgroundColor;
+    QFont _defaultFont;
+    QFont _doubleByteFont;
+    int _defaultFontPaddingLeft;
+    int _defaultFontPaddingBottom;
+    int _doubleByteFontPaddingLeft;
+    int _doubleByteFontPaddingBottom;
+    bool _rasterBackBuffer;
+};
+
+}   // namespace Qelly
+
+}   // namespace UJ
+
+#endif // RENDERSETTINGS_H
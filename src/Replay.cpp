@@ -0,0 +1,144 @@
+/*****************************************************************************
+ * Replay.cpp
+ *
+ * Created: 16/10 2026 by uranusjr
+ *
+ * Copyright 2026 uranusjr. All rights reserved.
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ *****************************************************************************/
+
+#include "Replay.h"
+#include <QTimer>
+#include "SessionRecording.h"
+#include "Site.h"
+
+namespace UJ
+{
+
+namespace Connection
+{
+
+// How long fast playback may feed the terminal before returning to the event
+// loop, so that the view still gets to paint now and then.
+static const qint64 FastSliceNsecs = 10 * 1000 * 1000;
+
+Replay::Replay(QObject *parent) : AbstractConnection(parent)
+{
+    _recording = 0;
+    _next = 0;
+    _fast = false;
+    _timer = new QTimer(this);
+    _timer->setSingleShot(true);
+    connect(_timer, SIGNAL(timeout()), this, SLOT(playNext()));
+}
+
+Replay::~Replay()
+{
+    delete _recording;
+}
+
+bool Replay::connectTo(const QString &address, qint16)
+{
+    setProcessing(true);
+
+    QString path = address;
+    _fast = path.endsWith("?fast");
+    if (_fast)
+        path.chop(5);
+
+    if (!_site)
+        setSite(new Site("replay://" + path, path, this));
+    delete _recording;
+    _recording = new SessionRecording(path);
+    if (!_recording->isValid())
+    {
+        setProcessing(false);
+        return false;
+    }
+
+    setConnected(true);
+    setProcessing(false);
+    emit connected();
+    reconnect();
+    return true;
+}
+
+void Replay::close()
+{
+    _timer->stop();
+    if (isConnected())
+        finish();
+}
+
+void Replay::reconnect()
+{
+    if (!_recording || !_recording->isValid())
+        return;
+    _next = 0;
+    _clock.start();
+    _timer->start(0);
+}
+
+void Replay::playNext()
+{
+    int count = _recording->count();
+    qint64 now = _clock.nsecsElapsed();
+    while (_next < count)
+    {
+        SessionRecording::Record record = _recording->record(_next);
+        if (!_fast && record.nsecs > now)
+        {
+            endBatch();
+            _timer->start((record.nsecs - now) / 1000000);
+            return;
+        }
+        if (_fast && _clock.nsecsElapsed() - now > FastSliceNsecs)
+        {
+            endBatch();
+            _timer->start(0);
+            return;
+        }
+        _next++;
+        if (record.direction == SessionRecording::DirectionInbound)
+            receiveChunk(record.bytes);
+    }
+
+    // Running out of records is not a disconnect; the parser is likely still
+    // working through the last batch, and the view stops drawing once the
+    // connection is gone. The final screen stays up until the tab is closed.
+    endBatch();
+}
+
+void Replay::finish()
+{
+    setConnected(false);
+    emit disconnected();
+}
+
+void Replay::processBytes(QByteArray bytes)
+{
+    // Recordings hold what the connection handed to the terminal, so there
+    // is nothing left to strip here.
+    deliver(bytes);
+}
+
+void Replay::sendBytes(QByteArray bytes)
+{
+    // The recorded session already contains the remote side's answers to
+    // whatever was sent; keep the traffic visible to listeners only.
+    if (!bytes.isEmpty())
+        emit sentBytes(bytes);
+}
+
+}   // namespace Connection
+
+}   // namespace UJ
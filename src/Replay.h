@@ -0,0 +1,71 @@
+/*****************************************************************************
+ * Replay.h
+ *
+ * Created: 16/10 2026 by uranusjr
+ *
+ * Copyright 2026 uranusjr. All rights reserved.
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ *****************************************************************************/
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "AbstractConnection.h"
+#include <QElapsedTimer>
+class QTimer;
+
+namespace UJ
+{
+
+namespace Connection
+{
+
+class SessionRecording;
+
+// Plays a session recording back as if it came from a live site. The address
+// is the path of the recording; append "?fast" to play it as fast as the
+// terminal can take it instead of at the recorded pace. The replay stays
+// connected after the last record, so its final screen can be looked at; it
+// only disconnects when closed.
+class Replay : public AbstractConnection
+{
+    Q_OBJECT
+
+public:
+    explicit Replay(QObject *parent = 0);
+    virtual ~Replay();
+    virtual bool connectTo(const QString &address, qint16 port);
+
+public slots:
+    virtual void close();
+    virtual void reconnect();
+    virtual void processBytes(QByteArray bytes);
+    virtual void sendBytes(QByteArray bytes);
+
+private slots:
+    void playNext();
+
+private:
+    void finish();
+
+    SessionRecording *_recording;
+    QTimer *_timer;
+    QElapsedTimer _clock;
+    int _next;
+    bool _fast;
+};
+
+}   // namespace Connection
+
+}   // namespace UJ
+
+#endif // REPLAY_H
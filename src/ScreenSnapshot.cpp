@@ -0,0 +1,155 @@
+/*****************************************************************************
+ * ScreenSnapshot.cpp
+ *
+ * Created: 16/10 2026 by uranusjr
+ *
+ * Copyright 2026 uranusjr. All rights reserved.
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ *****************************************************************************/
+
+#include "ScreenSnapshot.h"
+#include "Encodings.h"
+
+namespace UJ
+{
+
+namespace Connection
+{
+
+ScreenSnapshot::ScreenSnapshot(int rows, int columns) :
+    _rows(rows), _columns(columns), _cells(rows * columns),
+    _urlSpans(rows), _urlContinued(rows, false), _dirtyBegin(rows, columns),
+    _dirtyEnd(rows, 0), _dirtyRowCount(0), _rowOrigins(rows),
+    _cursorX(0), _cursorY(0)
+{
+    clearRowMoves();
+}
+
+QString ScreenSnapshot::stringFromIndex(int begin, int length,
+                                        BBS::Encoding encoding) const
+{
+    QString string;
+    uint temp = 0;
+    int space = 0;
+    for (int i = begin; i < begin + length; i++)
+    {
+        int x = i % _columns;
+        int y = i / _columns;
+        if (x == 0 && i != begin && i - 1 < begin + length) // newline
+        {
+            string.append(QChar('\n'));
+            space = 0;
+        }
+        const BBS::Cell &cell = cellsAtRow(y)[x];
+        switch (cell.attr.f.doubleByte)
+        {
+        case 0:
+            if (cell.byte == '\0' || cell.byte == ' ')
+            {
+                space++;
+            }
+            else
+            {
+                for (int j = 0; j < space; j++)
+                    string.append(QChar(' '));
+                string.append(QChar(cell.byte));
+                space = 0;
+            }
+            break;
+        case 1:
+            temp = cell.byte;
+            break;
+        case 2:
+            if (temp != 0)
+            {
+                uint code = (temp << 8) + cell.byte - 0x8000;
+                QChar c;
+                switch (encoding)
+                {
+                case BBS::EncodingBig5:
+                    c = QChar(YL::B2U[code]);
+                    break;
+                case BBS::EncodingGBK:
+                    c = QChar(YL::G2U[code]);
+                    break;
+                default:
+                    c = QChar();
+                    break;
+                }
+                for (int j = 0; j < space; j++)
+                    string.append(QChar(' '));
+                string.append(c);
+                space = 0;
+            }
+            break;
+        }
+    }
+    return string;
+}
+
+QString ScreenSnapshot::urlStringAt(int row, int column, bool *hasUrl) const
+{
+    const QVector<UrlSpan> &spans = _urlSpans[row];
+    int i = 0;
+    while (i < spans.size() && spans[i].end <= column)
+        i++;
+    *hasUrl = (i < spans.size() && spans[i].begin <= column);
+    if (!*hasUrl)
+        return QString();
+
+    // Find the row the URL starts in
+    UrlSpan span = spans[i];
+    while (span.begin == 0 && _urlContinued[row])
+    {
+        row--;
+        span = _urlSpans[row].last();
+    }
+
+    QString url;
+    while (true)
+    {
+        for (int x = span.begin; x < span.end; x++)
+            url.append(cellsAtRow(row)[x].byte);
+        if (row + 1 >= _rows || !_urlContinued[row + 1])
+            break;
+        row++;
+        span = _urlSpans[row].first();
+    }
+    return url;
+}
+
+void ScreenSnapshot::clearRowMoves()
+{
+    for (int y = 0; y < _rows; y++)
+        _rowOrigins[y] = y;
+    _hasMovedRows = false;
+}
+
+void ScreenSnapshot::mergeChangesFrom(const ScreenSnapshot &earlier)
+{
+    // A row that moved here brings along what was still to repaint in it,
+    // and the row it had come from before that
+    for (int y = 0; y < _rows; y++)
+    {
+        int origin = _rowOrigins[y];
+        if (origin < 0)
+            continue;
+        setDirtySpan(y, earlier._dirtyBegin[origin],
+                     earlier._dirtyEnd[origin]);
+        _rowOrigins[y] = earlier._rowOrigins[origin];
+    }
+    _hasMovedRows = _hasMovedRows || earlier._hasMovedRows;
+}
+
+}   // namespace Connection
+
+}   // namespace UJ
@@ -0,0 +1,183 @@
+/*****************************************************************************
+ * ScreenSnapshot.h
+ *
+ * Created: 16/10 2026 by uranusjr
+ *
+ * Copyright 2026 uranusjr. All rights reserved.
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ *****************************************************************************/
+
+#ifndef SCREENSNAPSHOT_H
+#define SCREENSNAPSHOT_H
+
+#include <QString>
+#include <QVector>
+#include "Globals.h"
+
+namespace UJ
+{
+
+namespace Connection
+{
+
+// Columns [begin, end) of a row that belong to a URL. A URL running off the
+// end of a row ends at the column count, and carries on from column 0 of the
+// next one.
+struct UrlSpan
+{
+    int begin;
+    int end;
+};
+
+// The screen of a terminal as it was after a batch of data was parsed. The
+// terminal parses on a worker thread and publishes one of these after each
+// batch; a view takes the latest one and reads it on the GUI thread while the
+// terminal carries on, so neither waits for the other.
+//
+// The cells, URLs and cursor never change once published. What does change
+// is the record of what to repaint: the dirty spans and the row moves since
+// the snapshot the view drew before, which the view clears as it draws. If
+// the view skips a snapshot, its changes are merged into the next one.
+class ScreenSnapshot
+{
+    friend class Terminal;
+
+public:
+    ScreenSnapshot(int rows, int columns);
+
+    inline int rowCount() const
+    {
+        return _rows;
+    }
+    inline int columnCount() const
+    {
+        return _columns;
+    }
+    inline const BBS::Cell *cellsAtRow(int row) const
+    {
+        return _cells.constData() + row * _columns;
+    }
+    inline BBS::CellAttribute attributeOfCellAt(int row, int column) const
+    {
+        return cellsAtRow(row)[column].attr;
+    }
+    // 1 for the lead byte of a double-byte character, 2 for the trail byte,
+    // 0 otherwise (including positions off the screen)
+    inline int doubleByteStateAt(int row, int column) const
+    {
+        if (column < 0 || column >= _columns)
+            return 0;
+        return cellsAtRow(row)[column].attr.f.doubleByte;
+    }
+    inline const QVector<UrlSpan> &urlSpansAtRow(int row) const
+    {
+        return _urlSpans[row];
+    }
+    inline int cursorRow() const
+    {
+        return _cursorY;
+    }
+    inline int cursorColumn() const
+    {
+        return _cursorX;
+    }
+    QString stringFromIndex(int begin, int length,
+                            BBS::Encoding encoding) const;
+    QString urlStringAt(int row, int column, bool *hasUrl) const;
+
+    // Columns [dirtyBeginAt(), dirtyEndAt()) of the row need repainting
+    inline bool isDirty() const
+    {
+        return _dirtyRowCount > 0;
+    }
+    inline bool isDirtyRow(int row) const
+    {
+        return _dirtyBegin[row] < _dirtyEnd[row];
+    }
+    inline int dirtyBeginAt(int row) const
+    {
+        return _dirtyBegin[row];
+    }
+    inline int dirtyEndAt(int row) const
+    {
+        return _dirtyEnd[row];
+    }
+    inline void setDirtySpan(int row, int begin, int end)
+    {
+        if (begin >= end)
+            return;
+        if (!isDirtyRow(row))
+            _dirtyRowCount++;
+        if (begin < _dirtyBegin[row])
+            _dirtyBegin[row] = begin;
+        if (end > _dirtyEnd[row])
+            _dirtyEnd[row] = end;
+    }
+    inline void setDirtyAt(int row, int column)
+    {
+        setDirtySpan(row, column, column + 1);
+    }
+    inline void setDirtyRow(int row, bool dirty = true)
+    {
+        if (dirty)
+        {
+            setDirtySpan(row, 0, _columns);
+        }
+        else if (isDirtyRow(row))
+        {
+            _dirtyBegin[row] = _columns;
+            _dirtyEnd[row] = 0;
+            _dirtyRowCount--;
+        }
+    }
+    inline void setDirtyAll()
+    {
+        for (int y = 0; y < _rows; y++)
+            setDirtyRow(y);
+    }
+
+    // The row each row was at in the snapshot drawn before, or -1 if it has
+    // been blanked by a scroll since; see Terminal::rowOriginAt()
+    inline bool hasMovedRows() const
+    {
+        return _hasMovedRows;
+    }
+    inline int rowOriginAt(int row) const
+    {
+        return _rowOrigins[row];
+    }
+    void clearRowMoves();
+
+    // Takes over what is still to repaint from a snapshot published before
+    // this one, as if it had been drawn and this one were all that changed
+    void mergeChangesFrom(const ScreenSnapshot &earlier);
+
+private:
+    int _rows;
+    int _columns;
+    QVector<BBS::Cell> _cells;
+    QVector<QVector<UrlSpan> > _urlSpans;
+    QVector<bool> _urlContinued;    // A URL runs into the row from above
+    QVector<int> _dirtyBegin;
+    QVector<int> _dirtyEnd;
+    int _dirtyRowCount;
+    QVector<int> _rowOrigins;
+    bool _hasMovedRows;
+    int _cursorX;
+    int _cursorY;
+};
+
+}   // namespace Connection
+
+}   // namespace UJ
+
+#endif // SCREENSNAPSHOT_H
@@ -0,0 +1,237 @@
+/*****************************************************************************
+ * SessionRecording.cpp
+ *
+ * Created: 16/10 2026 by uranusjr
+ *
+ * Copyright 2026 uranusjr. All rights reserved.
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ *****************************************************************************/
+
+#include "SessionRecording.h"
+#include <cstring>
+#include <QFile>
+#include <QtEndian>
+#include "AbstractConnection.h"
+
+namespace UJ
+{
+
+namespace Connection
+{
+
+const char SessionRecording::Magic[8] =
+        {'Q', 'E', 'L', 'L', 'Y', 'R', 'E', 'C'};
+const char SessionRecording::IndexMagic[8] =
+        {'Q', 'E', 'L', 'L', 'Y', 'I', 'D', 'X'};
+
+static inline qint64 paddedLength(qint64 length)
+{
+    return (length + 7) & ~qint64(7);
+}
+
+SessionRecording::SessionRecording(const QString &path)
+{
+    _data = 0;
+    _size = 0;
+    _file = new QFile(path);
+    if (!_file->open(QIODevice::ReadOnly))
+        return;
+    _size = _file->size();
+    if (_size < HeaderSize)
+        return;
+    _data = _file->map(0, _size);
+    if (!_data)
+        return;
+    if (memcmp(_data, Magic, sizeof(Magic)) != 0 ||
+            qFromLittleEndian<quint32>(_data + 8) != Version)
+    {
+        _file->unmap(const_cast<uchar *>(_data));
+        _data = 0;
+        return;
+    }
+    if (!readIndex())
+        scanRecords();
+}
+
+SessionRecording::~SessionRecording()
+{
+    if (_data)
+        _file->unmap(const_cast<uchar *>(_data));
+    delete _file;
+}
+
+bool SessionRecording::isValid() const
+{
+    return _data != 0;
+}
+
+int SessionRecording::count() const
+{
+    return _offsets.size();
+}
+
+SessionRecording::Record SessionRecording::record(int index) const
+{
+    const uchar *p = _data + _offsets.at(index);
+    Record r;
+    r.nsecs = qFromLittleEndian<qint64>(p);
+    r.direction = static_cast<Direction>(p[12]);
+    int length = qFromLittleEndian<quint32>(p + 8);
+    r.bytes = QByteArray::fromRawData(
+                reinterpret_cast<const char *>(p + RecordHeaderSize), length);
+    return r;
+}
+
+bool SessionRecording::readIndex()
+{
+    if (_size < HeaderSize + FooterSize)
+        return false;
+    const uchar *footer = _data + _size - FooterSize;
+    if (memcmp(footer + 16, IndexMagic, sizeof(IndexMagic)) != 0)
+        return false;
+    qint64 count = qFromLittleEndian<qint64>(footer);
+    qint64 indexOffset = qFromLittleEndian<qint64>(footer + 8);
+    if (indexOffset < HeaderSize || indexOffset > _size - FooterSize)
+        return false;
+
+    // Bounded before it is multiplied, so that a corrupt footer cannot wrap
+    // around to a size that passes
+    if (count < 0 || count > (_size - FooterSize - indexOffset) / 8 ||
+            indexOffset + count * 8 != _size - FooterSize)
+        return false;
+
+    _offsets.resize(count);
+    for (qint64 i = 0; i < count; i++)
+    {
+        qint64 offset = qFromLittleEndian<qint64>(_data + indexOffset + i * 8);
+        if (offset < HeaderSize || offset + RecordHeaderSize > indexOffset ||
+                offset + RecordHeaderSize +
+                qFromLittleEndian<quint32>(_data + offset + 8) > indexOffset)
+        {
+            _offsets.clear();
+            return false;
+        }
+        _offsets[i] = offset;
+    }
+    return true;
+}
+
+void SessionRecording::scanRecords()
+{
+    // Stop at the first record that does not fit; an unclean shutdown may
+    // have left one half written at the end.
+    qint64 offset = HeaderSize;
+    while (offset + RecordHeaderSize <= _size)
+    {
+        qint64 length = qFromLittleEndian<quint32>(_data + offset + 8);
+        if (offset + RecordHeaderSize + length > _size)
+            break;
+        _offsets.append(offset);
+        offset += RecordHeaderSize + paddedLength(length);
+    }
+}
+
+SessionRecorder::SessionRecorder(const QString &path,
+                                 AbstractConnection *connection) :
+    QObject(connection), _indexOffset(0)
+{
+    _file = new QFile(path, this);
+    if (!_file->open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return;
+
+    uchar header[SessionRecording::HeaderSize] = {0};
+    memcpy(header, SessionRecording::Magic, sizeof(SessionRecording::Magic));
+    qToLittleEndian<quint32>(SessionRecording::Version, header + 8);
+    _file->write(reinterpret_cast<const char *>(header), sizeof(header));
+    _clock.start();
+
+    connect(connection, SIGNAL(processedBytes(QByteArray)),
+            this, SLOT(recordInbound(QByteArray)));
+    connect(connection, SIGNAL(sentBytes(QByteArray)),
+            this, SLOT(recordOutbound(QByteArray)));
+    connect(connection, SIGNAL(disconnected()), this, SLOT(close()));
+    connect(connection, SIGNAL(connected()), this, SLOT(reopen()));
+}
+
+SessionRecorder::~SessionRecorder()
+{
+    close();
+}
+
+bool SessionRecorder::isOpen() const
+{
+    return _file->isOpen();
+}
+
+void SessionRecorder::close()
+{
+    if (!_file->isOpen())
+        return;
+
+    qint64 indexOffset = _file->pos();
+    QByteArray index(_offsets.size() * 8 + SessionRecording::FooterSize, 0);
+    uchar *p = reinterpret_cast<uchar *>(index.data());
+    for (int i = 0; i < _offsets.size(); i++)
+        qToLittleEndian<qint64>(_offsets.at(i), p + i * 8);
+    p += _offsets.size() * 8;
+    qToLittleEndian<qint64>(_offsets.size(), p);
+    qToLittleEndian<qint64>(indexOffset, p + 8);
+    memcpy(p + 16, SessionRecording::IndexMagic,
+           sizeof(SessionRecording::IndexMagic));
+    _file->write(index);
+    _file->close();
+    _indexOffset = indexOffset;
+}
+
+void SessionRecorder::reopen()
+{
+    // Records after a reconnect go on where the index was written, which is
+    // written again when the connection closes
+    if (_file->isOpen() || _indexOffset < SessionRecording::HeaderSize)
+        return;
+    if (!_file->open(QIODevice::ReadWrite))
+        return;
+    _file->resize(_indexOffset);
+    _file->seek(_indexOffset);
+}
+
+void SessionRecorder::recordInbound(QByteArray bytes)
+{
+    write(SessionRecording::DirectionInbound, bytes);
+}
+
+void SessionRecorder::recordOutbound(QByteArray bytes)
+{
+    write(SessionRecording::DirectionOutbound, bytes);
+}
+
+void SessionRecorder::write(SessionRecording::Direction direction,
+                            const QByteArray &bytes)
+{
+    if (!_file->isOpen() || bytes.isEmpty())
+        return;
+
+    uchar header[SessionRecording::RecordHeaderSize] = {0};
+    qToLittleEndian<qint64>(_clock.nsecsElapsed(), header);
+    qToLittleEndian<quint32>(bytes.size(), header + 8);
+    header[12] = static_cast<uchar>(direction);
+
+    _offsets.append(_file->pos());
+    _file->write(reinterpret_cast<const char *>(header), sizeof(header));
+    _file->write(bytes);
+    static const char padding[8] = {0};
+    _file->write(padding, paddedLength(bytes.size()) - bytes.size());
+}
+
+}   // namespace Connection
+
+}   // namespace UJ
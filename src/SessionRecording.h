@@ -0,0 +1,127 @@
+/*****************************************************************************
+ * SessionRecording.h
+ *
+ * Created: 16/10 2026 by uranusjr
+ *
+ * Copyright 2026 uranusjr. All rights reserved.
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ *****************************************************************************/
+
+#ifndef SESSIONRECORDING_H
+#define SESSIONRECORDING_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QVector>
+class QFile;
+
+// On-disk layout of a session recording. All integers are little endian, and
+// everything is 8-byte aligned so a mapped file can be read in place.
+//
+//  header      "QELLYREC"  quint32 version     quint32 reserved
+//  record      quint64 nsecs since start       quint32 length
+//              quint8 direction    3 bytes padding
+//              length bytes of payload, zero padded to a multiple of 8
+//  ...
+//  index       quint64 file offset of each record
+//  footer      quint64 record count    quint64 index offset    "QELLYIDX"
+//
+// The index and footer are written when the recording is closed cleanly. A
+// recording without them (e.g. the program crashed) is still readable; the
+// records are then found by walking the file from the start.
+
+namespace UJ
+{
+
+namespace Connection
+{
+
+class AbstractConnection;
+
+class SessionRecording
+{
+public:
+    enum Direction
+    {
+        DirectionInbound,       // What the connection handed to Terminal
+        DirectionOutbound       // What was sent to the remote side
+    };
+
+    struct Record
+    {
+        Direction direction;
+        qint64 nsecs;
+        QByteArray bytes;
+    };
+
+    explicit SessionRecording(const QString &path);
+    virtual ~SessionRecording();
+    bool isValid() const;
+    int count() const;
+
+    // The bytes of the returned record point into the mapped file; they stay
+    // valid as long as this recording is alive.
+    Record record(int index) const;
+
+    static const char Magic[8];
+    static const char IndexMagic[8];
+    static const quint32 Version = 1;
+    static const int HeaderSize = 16;
+    static const int RecordHeaderSize = 16;
+    static const int FooterSize = 24;
+
+private:
+    bool readIndex();
+    void scanRecords();
+
+    QFile *_file;
+    const uchar *_data;
+    qint64 _size;
+    QVector<qint64> _offsets;
+};
+
+class SessionRecorder : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Records everything going through the connection into a new file at
+    // path. The recorder is usually parented to the connection it records.
+    // The file is finished when the connection disconnects, and picked up
+    // again if it reconnects, so every session in a tab ends up in it.
+    explicit SessionRecorder(const QString &path,
+                             AbstractConnection *connection);
+    virtual ~SessionRecorder();
+    bool isOpen() const;
+
+public slots:
+    void close();
+    void reopen();
+    void recordInbound(QByteArray bytes);
+    void recordOutbound(QByteArray bytes);
+
+private:
+    void write(SessionRecording::Direction direction,
+               const QByteArray &bytes);
+
+    QFile *_file;
+    QElapsedTimer _clock;
+    QVector<qint64> _offsets;
+    qint64 _indexOffset;    // Where close() last wrote the index
+};
+
+}   // namespace Connection
+
+}   // namespace UJ
+
+#endif // SESSIONRECORDING_H
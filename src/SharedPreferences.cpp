@@ -24,6 +24,20 @@ namespace UJ
 namespace Qelly
 {
 
+QSharedPointer<const RenderSettings> SharedPreferences::renderSettings()
+{
+    if (!_renderSettings)
+        commitRenderSettings();
+    return _renderSettings;
+}
+
+void SharedPreferences::commitRenderSettings()
+{
+    _renderSettings = QSharedPointer<const RenderSettings>(
+                new RenderSettings(this, ++_renderVersion));
+    emit renderSettingsChanged();
+}
+
 }   // namespace Qelly
 
 }   // namespace UJ
@@ -27,7 +27,14 @@
 #include <QFontDatabase>
 #include <QPoint>
 #include <QSettings>
+#include <QSharedPointer>
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+    #include <QStandardPaths>
+#else
+    #include <QDesktopServices>
+#endif
 #include "Globals.h"
+#include "RenderSettings.h"
 #include "Ssh.h"
 
 namespace UJ
@@ -44,6 +51,7 @@ public:
     explicit SharedPreferences(QObject *parent = 0) : QObject(parent)
     {
         _settings = new QSettings("uranusjr.org", "qelly", this);
+        _renderVersion = 0;
     }
     static inline SharedPreferences *sharedInstance()
     {
@@ -51,8 +59,18 @@ public:
         return g;
     }
 
+    // What views draw with. Changes to the display preferences below reach
+    // the views only once they are committed.
+    QSharedPointer<const RenderSettings> renderSettings();
+    void commitRenderSettings();
+
+signals:
+    void renderSettingsChanged();
+
 private:
     QSettings *_settings;
+    QSharedPointer<const RenderSettings> _renderSettings;
+    int _renderVersion;
 
 public: // Setters & Getters
     inline QPoint windowPosition() const
@@ -104,6 +122,24 @@ public: // Setters & Getters
     {
         _settings->setValue("use system beep", use);
     }
+    inline bool rasterBackBuffer() const
+    {
+        // Draw into client memory with all cores instead of into a pixmap
+        return _settings->value("raster back buffer", false).toBool();
+    }
+    inline void setRasterBackBuffer(bool raster)
+    {
+        _settings->setValue("raster back buffer", raster);
+    }
+    inline int frameLatencyBudget() const
+    {
+        // Longest a view waits to draw data that arrives while it is idle
+        return _settings->value("frame latency budget", 2).toInt();
+    }
+    inline void setFrameLatencyBudget(int msecs)
+    {
+        _settings->setValue("frame latency budget", msecs);
+    }
     inline QString customBeepFile() const
     {
         return _settings->value("custom beep file", QString()).toString();
@@ -112,6 +148,32 @@ public: // Setters & Getters
     {
         _settings->setValue("custom beep file", filename);
     }
+    inline QString recordingDirectory() const
+    {
+        // Sessions are only recorded when this is set
+        return _settings->value("recording directory", QString()).toString();
+    }
+    inline void setRecordingDirectory(QString path)
+    {
+        _settings->setValue("recording directory", path);
+    }
+    inline QString glyphCacheDirectory() const
+    {
+        // Rasterized glyphs are kept on disk unless this is set empty
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+        QString location = QStandardPaths::writableLocation(
+                    QStandardPaths::CacheLocation);
+#else
+        QString location = QDesktopServices::storageLocation(
+                    QDesktopServices::CacheLocation);
+#endif
+        return _settings->value("glyph cache directory",
+                                location).toString();
+    }
+    inline void setGlyphCacheDirectory(QString path)
+    {
+        _settings->setValue("glyph cache directory", path);
+    }
 
     inline BBS::Encoding defaultEncoding() const
     {
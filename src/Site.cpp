@@ -50,6 +50,8 @@ Site::Site(QString form, QString name, QObject *parent) : QObject(parent)
             _type = TypeSsh;
         else if (comps.first() == "telnet")
             _type = TypeTelnet;
+        else if (comps.first() == "replay")
+            _type = TypeReplay;
         else
             _type = TypeTelnet;
         form = comps.last();
@@ -59,8 +61,9 @@ Site::Site(QString form, QString name, QObject *parent) : QObject(parent)
         _type = TypeTelnet;
     }
 
+    // A replay address is a file path, which may well contain colons
     comps = form.split(':');
-    if (comps.size() > 1)
+    if (comps.size() > 1 && _type != TypeReplay)
     {
         form = comps.first();
         _port = comps.last().toLong();
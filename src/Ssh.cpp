@@ -18,6 +18,7 @@
 
 #include "Ssh.h"
 #include <QProcess>
+#include "IoChannel.h"
 #include "SharedPreferences.h"
 #include "Site.h"
 
@@ -30,23 +31,17 @@ namespace Connection
 Ssh::Ssh(QObject *parent) : AbstractConnection(parent)
 {
     _site = 0;
-    _socket = new QProcess(this);
-
-    connect(this, SIGNAL(receivedBytes(QByteArray)),
-            this, SLOT(processBytes(QByteArray)));
-    connect(_socket, SIGNAL(started()), this, SLOT(onProcessStarted()));
-    connect(_socket, SIGNAL(readyReadStandardOutput()),
-            this, SLOT(onProcessReadyRead()));
-    connect(_socket, SIGNAL(error(QProcess::ProcessError)),
-            this, SLOT(onProcessError()));
-    connect(_socket, SIGNAL(finished(int, QProcess::ExitStatus)),
-            this, SLOT(onProcessFinished()));
-}
 
-Ssh::~Ssh()
-{
-    if (_socket->isOpen())
-        _socket->close();
+    // Set up before it moves to the reactor; the channel kills the process
+    // when the connection goes away
+    QProcess *process = new QProcess();
+    process->setReadChannel(QProcess::StandardOutput);
+    process->setReadChannelMode(QProcess::MergedChannels);
+    setChannel(new IoChannel(process));
+
+    connect(_channel, SIGNAL(opened()), this, SLOT(onProcessStarted()));
+    connect(_channel, SIGNAL(failed()), this, SLOT(onProcessError()));
+    connect(_channel, SIGNAL(closed()), this, SLOT(onProcessFinished()));
 }
 
 bool Ssh::connectTo(const QString &address, qint16 port)
@@ -56,9 +51,6 @@ bool Ssh::connectTo(const QString &address, qint16 port)
     if (!_site)
         setSite(new Site(address, address, this));
 
-    _socket->setReadChannel(QProcess::StandardOutput);
-    _socket->setReadChannelMode(QProcess::MergedChannels);
-
     port = port < 0 ? DefaultPort : port;
     QStringList args;
 
@@ -84,8 +76,9 @@ bool Ssh::connectTo(const QString &address, qint16 port)
              << address;
 #endif
 
-    _socket->start(Qelly::SharedPreferences::sharedInstance()->sshClientPath(),
-                   args);
+    Qelly::SharedPreferences *prefs =
+            Qelly::SharedPreferences::sharedInstance();
+    _channel->start(prefs->sshClientPath(), args);
 
     return true;
 }
@@ -105,16 +98,6 @@ void Ssh::onProcessStarted()
     emit connected();
 }
 
-void Ssh::onProcessReadyRead()
-{
-    while (_socket->bytesAvailable())
-    {
-        QByteArray data = _socket->read(512);
-        if (data.size() > 0)
-            emit receivedBytes(data);
-    }
-}
-
 void Ssh::onProcessError()
 {
     setProcessing(false);
@@ -129,7 +112,7 @@ void Ssh::onProcessFinished()
 
 void Ssh::processBytes(QByteArray bytes)
 {
-    emit processedBytes(bytes);
+    deliver(bytes);
 }
 
 void Ssh::sendBytes(QByteArray bytes)
@@ -137,7 +120,8 @@ void Ssh::sendBytes(QByteArray bytes)
     if (bytes.isEmpty())
         return;
 
-    _socket->write(bytes);
+    _channel->write(bytes);
+    emit sentBytes(bytes);
 }
 
 }   // namespace Connection
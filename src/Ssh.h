@@ -20,7 +20,6 @@
 #define SSH_H
 
 #include "AbstractConnection.h"
-class QProcess;
 
 namespace UJ
 {
@@ -34,12 +33,10 @@ class Ssh : public AbstractConnection
 
 public:
     explicit Ssh(QObject *parent = 0);
-    virtual ~Ssh();
     virtual bool connectTo(const QString &address, qint16 port);
     static const qint16 DefaultPort = 22;
 
 signals:
-    void receivedBytes(QByteArray data);
     void hasBytesToSend(QByteArray bytes);
 
 public slots:
@@ -50,12 +47,8 @@ public slots:
 
 private slots:
     void onProcessStarted();
-    void onProcessReadyRead();
     void onProcessError();
     void onProcessFinished();
-
-private:
-    QProcess *_socket;
 };
 
 }   // namespace Connection
@@ -17,9 +17,9 @@
  *****************************************************************************/
 
 #include "Telnet.h"
-#include <QAbstractSocket>
-#include <QHostInfo>
 #include <QTcpSocket>
+#include "IoChannel.h"
+#include "UJByteScan.h"
 #include "YLTelnet.h"
 #include "Site.h"
 
@@ -35,18 +35,12 @@ Telnet::Telnet(QObject *parent) : AbstractConnection(parent)
     _state = TOP_LEVEL;
     _synced = false;
     _sbBuffer = new QByteArray();
-    _socket = new QTcpSocket(this);
-    connect(this, SIGNAL(receivedBytes(QByteArray)),
-            this, SLOT(processBytes(QByteArray)));
+    setChannel(new IoChannel(new QTcpSocket()));
     connect(this, SIGNAL(hasBytesToSend(QByteArray)),
             this, SLOT(sendBytes(QByteArray)));
-    connect(_socket, SIGNAL(hostFound()), this, SLOT(onSocketHostFound()));
-    connect(_socket, SIGNAL(connected()), this, SLOT(onSocketConnected()));
-    connect(_socket, SIGNAL(readyRead()), this, SLOT(onSocketReadyRead()));
-    connect(_socket, SIGNAL(error(QAbstractSocket::SocketError)),
-            this, SLOT(onSocketError()));
-    connect(_socket, SIGNAL(disconnected()),
-            this, SLOT(onSocketDisconnected()));
+    connect(_channel, SIGNAL(opened()), this, SLOT(onSocketConnected()));
+    connect(_channel, SIGNAL(failed()), this, SLOT(onSocketError()));
+    connect(_channel, SIGNAL(closed()), this, SLOT(onSocketDisconnected()));
 }
 
 Telnet::~Telnet()
@@ -62,7 +56,7 @@ bool Telnet::connectTo(const QString &address, qint16 port)
 
     if (!_site)
         setSite(new Site(address, address, this));
-    _socket->connectToHost(address, _port);
+    _channel->connectToHost(address, _port);
 
     return true;
 }
@@ -75,10 +69,6 @@ void Telnet::reconnect()
 {
 }
 
-void Telnet::onSocketHostFound()
-{
-}
-
 void Telnet::onSocketConnected()
 {
     setConnected(true);
@@ -86,16 +76,6 @@ void Telnet::onSocketConnected()
     emit connected();
 }
 
-void Telnet::onSocketReadyRead()
-{
-    while (_socket->bytesAvailable())
-    {
-        QByteArray data = _socket->read(512);
-        if (data.size() > 0)
-            emit receivedBytes(data);
-    }
-}
-
 void Telnet::onSocketError()
 {
     setProcessing(false);
@@ -110,16 +90,34 @@ void Telnet::onSocketDisconnected()
 
 void Telnet::processBytes(QByteArray bytes)
 {
-    QQueue<uchar> buffer;
-    foreach (uchar c, bytes)
+    // The data is passed on as the runs of bytes between commands. Only when
+    // something has been taken out are the runs copied together; a chunk
+    // with nothing to take out is passed on as it is, without a copy.
+    const uchar *data = reinterpret_cast<const uchar *>(bytes.constData());
+    int size = bytes.size();
+    QByteArray output;
+    bool isCompacting = false;
+    int runBegin = 0;
+    for (int i = 0; i < size; i++)
     {
+        // Skip straight to the next byte that could start a command or a
+        // CR NUL pair; everything before it is data
+        if (_state == TOP_LEVEL && !_synced)
+        {
+            i += runLengthBefore(data + i, size - i, IAC, CR);
+            if (i == size)
+                break;
+        }
+
+        uchar c = data[i];
+        bool isData = false;
         switch (_state)
         {
         case TOP_LEVEL:
-            handleStateTopLevel(c, &buffer);
+            isData = handleStateTopLevel(c);
             break;
         case SEENCR:
-            handleStateSeenCr(c, &buffer);
+            isData = handleStateSeenCr(c);
             break;
         case SEENIAC:
             handleStateSeenIac(c);
@@ -155,59 +153,58 @@ void Telnet::processBytes(QByteArray bytes)
         default:
             break;
         }
+
+        if (!isData)
+        {
+            if (!isCompacting)
+            {
+                output.reserve(size);
+                isCompacting = true;
+            }
+            output.append(bytes.constData() + runBegin, i - runBegin);
+            runBegin = i + 1;
+        }
     }
 
-    int chunk_sz = 256;
-    while (!buffer.isEmpty())
+    if (!isCompacting)
     {
-        QByteArray data;
-        int length = buffer.size() < chunk_sz ? buffer.size() : chunk_sz;
-        for (int i = 0; i < length; i++)
-            data.append(buffer.dequeue());
-        emit processedBytes(data);
+        if (size > 0)
+            deliver(bytes);
+        return;
     }
+    output.append(bytes.constData() + runBegin, size - runBegin);
+    if (!output.isEmpty())
+        deliver(output);
 }
 
-void Telnet::handleStateTopLevel(uchar c, QQueue<uchar> *buffer)
+// Returns whether c is data to pass on
+bool Telnet::handleStateTopLevel(uchar c)
 {
-    switch (c)
+    if (c == IAC)
     {
-    case IAC:
         _state = SEENIAC;
-        break;
-    default:
-        if (!_synced)
-            buffer->enqueue(c);
-        else if (c == DM)
-            _synced = false;
-        if (c == CR)
-            _state = SEENCR;
-        else
-            _state = TOP_LEVEL;
-        break;
+        return false;
     }
+    _state = c == CR ? SEENCR : TOP_LEVEL;
+    if (!_synced)
+        return true;
+    if (c == DM)
+        _synced = false;
+    return false;
 }
 
-void Telnet::handleStateSeenCr(uchar c, QQueue<uchar> *buffer)
+bool Telnet::handleStateSeenCr(uchar c)
 {
     switch (c)
     {
     case NUL:
         _state = TOP_LEVEL;
-        break;
+        return false;
     case IAC:
         _state = SEENIAC;
-        break;
+        return false;
     default:
-        if (!_synced)
-            buffer->enqueue(c);
-        else if (c == DM)
-            _synced = false;
-        if (c == CR)
-            _state = SEENCR;
-        else
-            _state = TOP_LEVEL;
-        break;
+        return handleStateTopLevel(c);
     }
 }
 
@@ -323,25 +320,11 @@ void Telnet::sendCommand(uchar cmd, uchar option)
 
 void Telnet::sendBytes(QByteArray bytes)
 {
-    if (bytes.isEmpty())
-        return;
-    switch (_socket->state())
-    {
-    case QAbstractSocket::UnconnectedState:
-    case QAbstractSocket::HostLookupState:
-    case QAbstractSocket::ConnectingState:
-    case QAbstractSocket::ClosingState:
-        return;
-    default:
-        break;
-    }
-    qint64 sz = _socket->write(bytes);
-    if (sz == bytes.size())
+    // Bytes sent before the connection is up are dropped
+    if (bytes.isEmpty() || !isConnected())
         return;
-    else if (sz <= 0)
-        emit hasBytesToSend(bytes);
-    else
-        emit hasBytesToSend(bytes.mid(sz)); // restart from want we left off
+    _channel->write(bytes);
+    emit sentBytes(bytes);
 }
 
 }   // namespace Connection
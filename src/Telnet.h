@@ -20,10 +20,7 @@
 #define TELNET_H
 
 #include "AbstractConnection.h"
-#include <QQueue>
-class QHostAddress;
-class QHostInfo;
-class QTcpSocket;
+class TelnetScanChecker;
 
 namespace UJ
 {
@@ -34,6 +31,7 @@ namespace Connection
 class Telnet : public AbstractConnection
 {
     Q_OBJECT
+    friend class ::TelnetScanChecker;
 
 public:
     explicit Telnet(QObject *parent = 0);
@@ -54,15 +52,13 @@ protected slots:
     virtual void sendCommand(uchar cmd, uchar option);
 
 private slots:
-    void onSocketHostFound();
     void onSocketConnected();
-    void onSocketReadyRead();
     void onSocketError();
     void onSocketDisconnected();
 
 private:
-    void handleStateTopLevel(uchar c, QQueue<uchar> *buffer);
-    void handleStateSeenCr(uchar c, QQueue<uchar> *buffer);
+    bool handleStateTopLevel(uchar c);
+    bool handleStateSeenCr(uchar c);
     void handleStateSeenIac(uchar c);
     void handleStateSeenWill(uchar c);
     void handleStateSeenDo(uchar c);
@@ -70,7 +66,6 @@ private:
 
     QByteArray *_sbBuffer;
     uchar _sbOption;
-    QTcpSocket *_socket;
     qint16 _port;
     bool _synced;
 
@@ -17,12 +17,16 @@
  *****************************************************************************/
 
 #include "Terminal.h"
+#include <algorithm>
 #include <QApplication>
-#include <QSet>
+#include <QRunnable>
+#include <QThreadPool>
 #include "AbstractConnection.h"
 #include "Encodings.h"
 #include "Globals.h"
+#include "ParserProfiler.h"
 #include "Site.h"
+#include "UJByteScan.h"
 #include "View.h"
 
 namespace UJ
@@ -31,24 +35,96 @@ namespace UJ
 namespace Connection
 {
 
+namespace
+{
+
+// Protocols that start a URL. Candidates are looked up by the first byte, so
+// almost every cell is turned down with a single table read.
+const char *const UrlProtocols[] = {
+    "http://", "https://", "ftp://", "telnet://", "bbs://", "ssh://",
+    "mailto:"
+};
+const int UrlProtocolCount = sizeof(UrlProtocols) / sizeof(UrlProtocols[0]);
+
+class UrlMatcher
+{
+public:
+    UrlMatcher()
+    {
+        for (int c = 0; c < 256; c++)
+            _candidates[c] = 0;
+        for (int p = 0; p < UrlProtocolCount; p++)
+        {
+            _lengths[p] = ::strlen(UrlProtocols[p]);
+            _candidates[uchar(UrlProtocols[p][0])] |= 1 << p;
+        }
+    }
+
+    // Whether a protocol starts at the first of the given cells
+    bool matches(const BBS::Cell *cells, int size) const
+    {
+        uint candidates = _candidates[cells[0].byte];
+        for (int p = 0; candidates; p++, candidates >>= 1)
+        {
+            if (!(candidates & 1) || _lengths[p] > size)
+                continue;
+            int s = 1;
+            while (s < _lengths[p] && cells[s].byte == UrlProtocols[p][s])
+                s++;
+            if (s == _lengths[p])
+                return true;
+        }
+        return false;
+    }
+
+private:
+    uchar _candidates[256];     // Bit p is set if protocol p starts with c
+    int _lengths[UrlProtocolCount];
+};
+
+// Built at startup like _transitions, rather than on first use, which may be
+// on any of the parser's pool threads at once
+const UrlMatcher urlMatcher;
+
+}   // namespace
+
+class Terminal::ParseTask : public QRunnable
+{
+public:
+    explicit ParseTask(Terminal *terminal) : _terminal(terminal)
+    {
+    }
+
+    virtual void run()
+    {
+        _terminal->parseQueuedData();
+    }
+
+private:
+    Terminal *_terminal;
+};
+
 Terminal::Terminal(QObject *parent) : QObject(parent)
 {
-    _csArg = new QQueue<int>();
-    _csBuf = new QQueue<int>();
     initSettings();
     initCells();
     _connection = 0;
-    _csTemp = 0;
+    _parsing = false;
+    publish();
+    connect(this, SIGNAL(bell()), this, SLOT(ringBell()));
 }
 
 Terminal::~Terminal()
 {
-    delete _csArg;
-    delete _csBuf;
-    delete [] _dirty;
-    for (int i = 0; i < _row; i++)
-        delete [] _cells[i];
+    waitForParser();
+    delete [] _dirtyBegin;
+    delete [] _dirtyEnd;
+    delete [] _doubleByteBegin;
+    delete [] _doubleByteEnd;
+    delete [] _urlRows;
+    delete [] _rowOrigins;
     delete [] _cells;
+    delete [] _screen;
 }
 
 void Terminal::initSettings()
@@ -65,25 +141,49 @@ void Terminal::initSettings()
     _lnm = true;
     _irm = false;
     _state = StateNormal;
+    _charsets[0] = 'B';
+    _charsets[1] = 'B';
+    _shift = 0;
     _standard = StandardVT102;
 }
 
 void Terminal::initCells()
 {
+    // The whole screen is one block; _cells only says where each row starts,
+    // so moving rows around never touches the cells themselves. In case
+    // _cursorX will exceed _column size (at the border of the screen), each
+    // row has one more unit than needed.
+    _screen = new BBS::Cell[_row * (_column + 1)];
     _cells = new BBS::Cell *[_row];
+    for (int i = 0; i < _row; i++)
+        _cells[i] = _screen + i * (_column + 1);
+    _dirtyBegin = new int[_row];
+    _dirtyEnd = new int[_row];
+    _dirtyRowCount = 0;
+    for (int i = 0; i < _row; i++)
+    {
+        _dirtyBegin[i] = _column;
+        _dirtyEnd[i] = 0;
+    }
+    _doubleByteBegin = new int[_row];
+    _doubleByteEnd = new int[_row];
+    _rowOrigins = new int[_row];
+    clearRowMoves();
+    _urlRows = new UrlRow[_row];
     for (int i = 0; i < _row; i++)
     {
-        // In case _cursorX will exceed _column size (at the border of the
-        // screen), we allocate one more unit for this array
-        _cells[i] = new BBS::Cell[_column + 1];
+        _urlRows[i].continued = false;
+        _urlRows[i].continues = false;
     }
-    _dirty = new int[_row * _column];
     clearAll();
 }
 
 void Terminal::startConnection()
 {
+    waitForParser();
     clearAll();
+    publish();
+    emit dataProcessed();
     _view->update();
 }
 
@@ -97,6 +197,7 @@ void Terminal::clearAll()
     _cursorX = 0;
     _cursorY = 0;
     BBS::CellAttribute a;
+    a.v = 0;
     a.f.fColorIndex = BBS::ColorIndexForeground;
     a.f.bColorIndex = BBS::ColorIndexBackground;
     a.f.bright = 0;
@@ -104,35 +205,55 @@ void Terminal::clearAll()
     a.f.blinking = 0;
     a.f.reversed = 0;
     a.f.isUrl = 0;
-    a.f.isNothing = 0;
+    a.f.isGraphic = 0;
     _emptyAttr = a.v;
-    for (int i = 0; i < _row; i++)
-        clearRow(i);
-    _csBuf->clear();
-    _csArg->clear();
+    _csParams.clear();
 
+    // Reset before the rows are cleared, which blank with these
     _fColorIndex = a.f.fColorIndex;
     _bColorIndex = a.f.bColorIndex;
-    _csTemp = 0;
     _state = StateNormal;
     _bright = false;
     _underlined = false;
     _blinking = false;
     _reversed = false ^ _screenReverse;
+    for (int i = 0; i < _row; i++)
+        clearRow(i);
 }
 
 void Terminal::clearRow(int row, int columnStart, int columnEnd)
 {
-    if (columnEnd == PositionNotFound)
+    PROFILE_PARSER(HandlerClearRow);
+    if (columnEnd == PositionNotFound || columnEnd > _column - 1)
         columnEnd = _column - 1;
-    for (int x = columnStart; x <= columnEnd; x++)
+    BBS::Cell blank;
+    blank.byte = '\0';
+    blank.attr.v = _emptyAttr;
+    blank.attr.f.bColorIndex = _bColorIndex;
+    blank.attr.f.reversed = _reversed;
+    BBS::Cell *cells = _cells[row];
+    if (columnStart <= columnEnd)
+        std::fill(cells + columnStart, cells + columnEnd + 1, blank);
+    setDirtySpan(row, columnStart, columnEnd + 1);
+
+    // A blank row has no double-byte characters to work out
+    if (columnStart <= 0 && columnEnd == _column - 1)
     {
-        _cells[row][x].byte = '\0';
-        _cells[row][x].attr.v = _emptyAttr;
-        _cells[row][x].attr.f.bColorIndex = _bColorIndex;
-        _cells[row][x].attr.f.reversed = _reversed;
-        _dirty[row * _column + x] = true;
+        _doubleByteBegin[row] = _column;
+        _doubleByteEnd[row] = -1;
+        _urlRows[row].dirty = true;
     }
+    else if (columnStart <= columnEnd)
+    {
+        invalidateBytes(row, columnStart, columnEnd);
+    }
+}
+
+void Terminal::clearRowMoves()
+{
+    for (int y = 0; y < _row; y++)
+        _rowOrigins[y] = y;
+    _hasMovedRows = false;
 }
 
 void Terminal::reverseAll()
@@ -144,20 +265,20 @@ void Terminal::reverseAll()
             int colorIndex = _cells[y][x].attr.f.bColorIndex;
             _cells[y][x].attr.f.bColorIndex = _cells[y][x].attr.f.fColorIndex;
             _cells[y][x].attr.f.fColorIndex = colorIndex;
-            _dirty[y * _column + x] = true;
         }
     }
+    setDirtyAll();
 }
 
 void Terminal::setByteUnderCursor(uchar c)
 {
+    PROFILE_PARSER(HandlerPrint);
     if (_cursorX <= _column - 1 && _irm)
     {
-        for (int x = _column - 1; x > _cursorX; x--)
-        {
-            _cells[_cursorY][x] = _cells[_cursorY][x - 1];
-            setDirtyAt(_cursorY, x);
-        }
+        BBS::Cell *cells = _cells[_cursorY];
+        std::copy_backward(cells + _cursorX, cells + _column - 1,
+                           cells + _column);
+        invalidateBytes(_cursorY, _cursorX, _column - 1);
     }
     else if (_cursorX == _column && _autowrap)
     {
@@ -165,6 +286,10 @@ void Terminal::setByteUnderCursor(uchar c)
         _hasWrapped = true;
         goOneRowDown();
     }
+    else if (_cursorX >= _column)   // No autowrap; keep overwriting the end
+    {
+        _cursorX = _column - 1;
+    }
     _cells[_cursorY][_cursorX].byte = c;
     _cells[_cursorY][_cursorX].attr.f.fColorIndex = _fColorIndex;
     _cells[_cursorY][_cursorX].attr.f.bColorIndex = _bColorIndex;
@@ -173,15 +298,72 @@ void Terminal::setByteUnderCursor(uchar c)
     _cells[_cursorY][_cursorX].attr.f.blinking = _blinking;
     _cells[_cursorY][_cursorX].attr.f.reversed = _reversed;
     _cells[_cursorY][_cursorX].attr.f.isUrl = false;
-    setDirtyAt(_cursorY, _cursorX);
+    _cells[_cursorY][_cursorX].attr.f.isGraphic = charset() == '0';
+    invalidateBytes(_cursorY, _cursorX, _cursorX);
     _cursorX++;
+    PROFILE_PARSER_CELLS(1);
+}
+
+void Terminal::setBytesUnderCursor(const uchar *bytes, int length)
+{
+    // Same as calling setByteUnderCursor() for each byte, but one row segment
+    // at a time. Only valid with autowrap on and insert mode off.
+    PROFILE_PARSER(HandlerPrint);
+    PROFILE_PARSER_CELLS(length);
+
+    // Everything setByteUnderCursor() assigns, in one go; the double-byte
+    // state is worked out later by updateDoubleByteStateForRow().
+    BBS::CellAttribute stamp;
+    stamp.v = 0;
+    stamp.f.fColorIndex = _fColorIndex;
+    stamp.f.bColorIndex = _bColorIndex;
+    stamp.f.bright = _bright;
+    stamp.f.underlined = _underlined;
+    stamp.f.blinking = _blinking;
+    stamp.f.reversed = _reversed;
+    stamp.f.isGraphic = charset() == '0';
+    BBS::CellAttribute keep;
+    keep.v = 0;
+    keep.f.doubleByte = 3;
+
+    while (length > 0)
+    {
+        if (_cursorX == _column)
+        {
+            _cursorX = 0;
+            _hasWrapped = true;
+            goOneRowDown();
+        }
+        int count = qMin(length, _column - _cursorX);
+        BBS::Cell *cells = _cells[_cursorY] + _cursorX;
+        for (int i = 0; i < count; i++)
+        {
+            cells[i].byte = bytes[i];
+            cells[i].attr.v = (cells[i].attr.v & keep.v) | stamp.v;
+        }
+        invalidateBytes(_cursorY, _cursorX, _cursorX + count - 1);
+        _cursorX += count;
+        bytes += count;
+        length -= count;
+    }
 }
 
 void Terminal::updateDoubleByteStateForRow(int row)
 {
+    int begin = _doubleByteBegin[row];
+    int end = _doubleByteEnd[row];
+    if (begin > end)
+        return;
+    PROFILE_PARSER(HandlerDoubleByte);
+    _doubleByteBegin[row] = _column;
+    _doubleByteEnd[row] = -1;
+
+    // Everything left of begin is unchanged, so the state carries on from
+    // there. Past end, stop as soon as a cell's state comes out the same as
+    // before; the rest of the row cannot change either.
     BBS::Cell *cells = _cells[row];
-    int db = 0;
-    for (int i = 0; i < _column; i++)
+    int db = begin > 0 ? cells[begin - 1].attr.f.doubleByte : 0;
+    for (int i = begin; i < _column; i++)
     {
         switch (db)
         {
@@ -196,20 +378,40 @@ void Terminal::updateDoubleByteStateForRow(int row)
             db = 2;
             break;
         }
+        if (i > end)
+        {
+            if (cells[i].attr.f.doubleByte == db)
+                break;
+            setDirtyAt(row, i);
+        }
         cells[i].attr.f.doubleByte = db;
     }
 }
 
-void Terminal::updateUrlStateForRow(int row)
+void Terminal::updateUrlStateForRows()
 {
-    QSet<const char *> protocols;
-    protocols << "http://" << "https://" << "ftp://" << "telnet://"
-              << "bbs://"  << "ssh://"   << "mailto:";
+    // A row needs another look if its bytes changed, or if it is no longer
+    // continuing the same URL from the row above (as after a scroll).
+    bool continued = false;
+    for (int y = 0; y < _row; y++)
+    {
+        UrlRow &urls = _urlRows[y];
+        if (urls.dirty || urls.continued != continued)
+            updateUrlStateForRow(y, continued);
+        continued = urls.continues;
+    }
+}
 
-    bool isUrl = false;
-    if (row > 0)
-        isUrl = _cells[row - 1][_column - 1].attr.f.isUrl;
+void Terminal::updateUrlStateForRow(int row, bool continued)
+{
+    PROFILE_PARSER(HandlerUrl);
+    UrlRow &urls = _urlRows[row];
+    urls.spans.clear();
+    urls.dirty = false;
+    urls.continued = continued;
 
+    bool isUrl = continued;
+    int begin = 0;
     BBS::Cell *cells = _cells[row];
     for (int i = 0; i < _column; i++)
     {
@@ -217,27 +419,16 @@ void Terminal::updateUrlStateForRow(int row)
         {
             uchar c = cells[i].byte;
             if (c < 0x21 || c > 0x7e || c == ')')
+            {
+                UrlSpan span = { begin, i };
+                urls.spans.append(span);
                 isUrl = false;
+            }
         }
-        else
+        else if (urlMatcher.matches(cells + i, _column - i))
         {
-            foreach(const char *p, protocols)
-            {
-                bool matched = true;
-                for (uint s = 0; s < ::strlen(p); s++)
-                {
-                    if (cells[i + s].byte != p[s])
-                    {
-                        matched = false;
-                        break;
-                    }
-                }
-                if (matched)
-                {
-                    isUrl = true;
-                    break;
-                }
-            }
+            begin = i;
+            isUrl = true;
         }
         if (cells[i].attr.f.isUrl != isUrl)
         {
@@ -245,23 +436,19 @@ void Terminal::updateUrlStateForRow(int row)
             setDirtyAt(row, i);
         }
     }
+    if (isUrl)
+    {
+        UrlSpan span = { begin, _column };
+        urls.spans.append(span);
+    }
+    urls.continues = isUrl;
 }
 
-void Terminal::goOneRowDown(bool updateView)
+void Terminal::goOneRowDown()
 {
     if (_cursorY == _scrollEndRow)
     {
-        if (updateView)
-        {
-            _view->updateBackImage();
-            _view->extendBottom(_scrollBeginRow, _scrollEndRow);
-        }
-        BBS::Cell *emptyLine = _cells[_scrollBeginRow];
-        clearRow(_scrollBeginRow);
-        for (int x = _scrollBeginRow; x < _scrollEndRow; x++)
-            _cells[x] = _cells[x + 1];
-        _cells[_scrollEndRow] = emptyLine;
-        setDirtyAll();
+        scrollRows(_scrollBeginRow, _scrollEndRow, 1);
     }
     else
     {
@@ -271,21 +458,11 @@ void Terminal::goOneRowDown(bool updateView)
     }
 }
 
-void Terminal::goOneRowUp(bool updateView)
+void Terminal::goOneRowUp()
 {
     if (_cursorY == _scrollBeginRow)
     {
-        if (updateView)
-        {
-            _view->updateBackImage();
-            _view->extendTop(_scrollBeginRow, _scrollEndRow);
-        }
-        BBS::Cell *emptyLine = _cells[_scrollEndRow];
-        clearRow(_scrollEndRow);
-        for (int x = _scrollEndRow; x > _scrollBeginRow; x--)
-            _cells[x] = _cells[x - 1];
-        _cells[_scrollBeginRow] = emptyLine;
-        setDirtyAll();
+        scrollRows(_scrollBeginRow, _scrollEndRow, -1);
     }
     else
     {
@@ -295,25 +472,167 @@ void Terminal::goOneRowUp(bool updateView)
     }
 }
 
+void Terminal::scrollRows(int first, int last, int count)
+{
+    // Moves rows first to last up by count (down if count is negative) by
+    // rotating everything kept per row, then blanks the rows exposed at the
+    // other end. The cost does not depend on count.
+    PROFILE_PARSER(HandlerScroll);
+    int n = qMin(count < 0 ? -count : count, last - first + 1);
+    if (n == 0)
+        return;
+    int middle = count > 0 ? first + n : last + 1 - n;
+    int end = last + 1;
+    std::rotate(_cells + first, _cells + middle, _cells + end);
+    std::rotate(_urlRows + first, _urlRows + middle, _urlRows + end);
+    std::rotate(_rowOrigins + first, _rowOrigins + middle, _rowOrigins + end);
+    std::rotate(_dirtyBegin + first, _dirtyBegin + middle, _dirtyBegin + end);
+    std::rotate(_dirtyEnd + first, _dirtyEnd + middle, _dirtyEnd + end);
+    std::rotate(_doubleByteBegin + first, _doubleByteBegin + middle,
+                _doubleByteBegin + end);
+    std::rotate(_doubleByteEnd + first, _doubleByteEnd + middle,
+                _doubleByteEnd + end);
+    _hasMovedRows = true;
+
+    int exposed = count > 0 ? end - n : first;
+    for (int y = exposed; y < exposed + n; y++)
+    {
+        clearRow(y);
+        _rowOrigins[y] = -1;
+    }
+}
+
+// The transition table of the parser. Every entry packs the action to take
+// for a byte in the low nibble and the state to go to in the high nibble.
+// C++98 has no constexpr, so the table is filled in once at startup instead.
+struct Terminal::Transitions
+{
+    enum Action
+    {
+        ActionIgnore,
+        ActionPrint,
+        ActionExecute,          // C0 control, acted upon in any state
+        ActionClear,            // Start of a new sequence
+        ActionCollect,          // Intermediate byte
+        ActionParameter,        // Parameter byte of a control sequence
+        ActionEscapeDispatch,
+        ActionControlDispatch
+    };
+
+    Transitions()
+    {
+        for (int s = 0; s < StateCount; s++)
+        {
+            // Anywhere: controls are executed without leaving the sequence,
+            // except that CAN and SUB abort it and ESC starts a new one.
+            set(s, 0x00, 0x1f, ActionExecute, s);
+            set(s, ASC_CAN, ASC_CAN, ActionExecute, StateNormal);
+            set(s, ASC_SUB, ASC_SUB, ActionExecute, StateNormal);
+            set(s, ASC_ESC, ASC_ESC, ActionClear, StateEscape);
+            set(s, ASC_DEL, ASC_DEL, ActionIgnore, s);
+            // Bytes above 0x7f are double-byte characters, never C1 controls.
+            // Inside a sequence they break it off, and are dropped.
+            set(s, 0x80, 0xff, ActionIgnore, StateNormal);
+        }
+
+        set(StateNormal, 0x20, 0x7e, ActionPrint, StateNormal);
+        set(StateNormal, 0x80, 0xff, ActionPrint, StateNormal);
+
+        set(StateEscape, 0x20, 0x2f, ActionCollect, StateEscapeIntermediate);
+        set(StateEscape, 0x30, 0x7e, ActionEscapeDispatch, StateNormal);
+        set(StateEscape, ESC_CSI, ESC_CSI, ActionClear, StateControl);
+        set(StateEscape, ESC_DCS, ESC_DCS, ActionIgnore, StateString);
+        set(StateEscape, ESC_SOS, ESC_SOS, ActionIgnore, StateString);
+        set(StateEscape, ESC_OSC, ESC_APC, ActionIgnore, StateString);
+
+        set(StateEscapeIntermediate, 0x20, 0x2f,
+            ActionCollect, StateEscapeIntermediate);
+        set(StateEscapeIntermediate, 0x30, 0x7e,
+            ActionEscapeDispatch, StateNormal);
+
+        set(StateControl, 0x20, 0x2f, ActionCollect, StateControlIntermediate);
+        set(StateControl, 0x30, 0x3f, ActionParameter, StateControl);
+        set(StateControl, 0x40, 0x7e, ActionControlDispatch, StateNormal);
+
+        set(StateControlIntermediate, 0x20, 0x2f,
+            ActionCollect, StateControlIntermediate);
+        set(StateControlIntermediate, 0x30, 0x3f,
+            ActionIgnore, StateControlIgnore);
+        set(StateControlIntermediate, 0x40, 0x7e,
+            ActionControlDispatch, StateNormal);
+
+        set(StateControlIgnore, 0x20, 0x3f, ActionIgnore, StateControlIgnore);
+        set(StateControlIgnore, 0x40, 0x7e, ActionIgnore, StateNormal);
+
+        // Strings end with ST (ESC \, handled by the ESC entry above), or BEL
+        // as xterm allows for OSC. Everything in between is thrown away.
+        set(StateString, 0x00, 0xff, ActionIgnore, StateString);
+        set(StateString, ASC_BEL, ASC_BEL, ActionIgnore, StateNormal);
+        set(StateString, ASC_CAN, ASC_CAN, ActionIgnore, StateNormal);
+        set(StateString, ASC_SUB, ASC_SUB, ActionIgnore, StateNormal);
+        set(StateString, ASC_ESC, ASC_ESC, ActionClear, StateEscape);
+    }
+
+    inline void set(int state, int first, int last, Action action, int next)
+    {
+        for (int c = first; c <= last; c++)
+            table[state][c] = static_cast<uchar>(action | (next << 4));
+    }
+
+    uchar table[StateCount][256];
+};
+
+const Terminal::Transitions Terminal::_transitions;
+
 void Terminal::processIncomingData(QByteArray bytes)
 {
-    const char *data = bytes.constData();
-    for (int i = 0; i < bytes.size(); i++)
+    PROFILE_PARSER(HandlerDispatch);
+    const uchar *data = reinterpret_cast<const uchar *>(bytes.constData());
+    int size = bytes.size();
+    for (int i = 0; i < size; i++)
     {
         uchar c = data[i];
-        switch (_state)
+        uchar transition = _transitions.table[_state][c];
+        _state = static_cast<State>(transition >> 4);
+        switch (transition & 0x0f)
         {
-        case StateNormal:
+        case Transitions::ActionPrint:
+            if (!_irm && _autowrap && _cursorX <= _column)
+            {
+                int length = printableRunLength(data + i, size - i);
+                setBytesUnderCursor(data + i, length);
+                i += length - 1;
+            }
+            else
+            {
+                setByteUnderCursor(c);
+            }
+            break;
+        case Transitions::ActionExecute:
             handleNormalDataInput(c);
             break;
-        case StateEscape:
-            handleEscapeDataInput(c, &i, bytes);
+        case Transitions::ActionClear:
+            _csParams.clear();
             break;
-        case StateControl:
-            handleControlDataInput(c);
+        case Transitions::ActionCollect:
+            _csParams.addIntermediate(c);
             break;
-        case StateScs:
-            _state = StateNormal;   // NOTE: NEED IMPLEMENTATION
+        case Transitions::ActionParameter:
+            if (c >= '0' && c <= '9')
+                _csParams.addDigit(c);
+            else if (c == ';' || c == ':')
+                _csParams.addSeparator(c);
+            else                            // Private prefix, '<' to '?'
+                _csParams.setPrefix(c);
+            break;
+        case Transitions::ActionEscapeDispatch:
+            if (_csParams.intermediateCount())
+                handleEscapeIntermediateInput(c);
+            else
+                handleEscapeDataInput(c);
+            break;
+        case Transitions::ActionControlDispatch:
+            handleControlNonSimpleShiftingInputs(c);
             break;
         default:
             break;
@@ -321,15 +640,113 @@ void Terminal::processIncomingData(QByteArray bytes)
     }
 
     for (int i = 0; i < _row; i++)
-    {
         updateDoubleByteStateForRow(i);
-        updateUrlStateForRow(i);
+    updateUrlStateForRows();
+}
+
+void Terminal::queueIncomingData(QByteArray bytes)
+{
+    receiveData(bytes);
+    endBatch();
+}
+
+void Terminal::receiveData(const QByteArray &bytes)
+{
+    _received.append(bytes);
+}
+
+void Terminal::endBatch()
+{
+    if (_received.isEmpty())
+        return;
+    QMutexLocker locker(&_inputLock);
+    _input.append(_received);
+    _received.clear();
+    if (_parsing)
+        return;
+    _parsing = true;
+    QThreadPool::globalInstance()->start(new ParseTask(this));
+}
+
+void Terminal::parseQueuedData()
+{
+    // Everything received by the time a batch starts is parsed before the
+    // screen is published; more may have arrived by the time it is done
+    while (true)
+    {
+        QList<QByteArray> batch;
+        {
+            QMutexLocker locker(&_inputLock);
+            if (_input.isEmpty())
+            {
+                _parsing = false;
+                _parserIdle.wakeAll();
+                return;
+            }
+            batch.swap(_input);
+        }
+        for (int i = 0; i < batch.size(); i++)
+            processIncomingData(batch.at(i));
+        publish();
+        emit dataProcessed();
     }
-    emit dataProcessed();
+}
+
+void Terminal::waitForParser()
+{
+    // Drops what is still queued; only used when the screen starts over
+    _received.clear();
+    QMutexLocker locker(&_inputLock);
+    _input.clear();
+    while (_parsing)
+        _parserIdle.wait(&_inputLock);
+}
+
+void Terminal::publish()
+{
+    ScreenSnapshot *s = new ScreenSnapshot(_row, _column);
+    for (int y = 0; y < _row; y++)
+    {
+        std::copy(_cells[y], _cells[y] + _column,
+                  s->_cells.data() + y * _column);
+        s->_urlSpans[y] = _urlRows[y].spans;
+        s->_urlContinued[y] = _urlRows[y].continued;
+        s->_dirtyBegin[y] = _dirtyBegin[y];
+        s->_dirtyEnd[y] = _dirtyEnd[y];
+        s->_rowOrigins[y] = _rowOrigins[y];
+    }
+    s->_dirtyRowCount = _dirtyRowCount;
+    s->_hasMovedRows = _hasMovedRows;
+    s->_cursorX = _cursorX;
+    s->_cursorY = _cursorY;
+    setDirtyUnder(0, false);
+    clearRowMoves();
+
+    QSharedPointer<ScreenSnapshot> snapshot(s);
+    QMutexLocker locker(&_snapshotLock);
+    if (_snapshot)      // The view has not got round to the last one
+        snapshot->mergeChangesFrom(*_snapshot);
+    _snapshot = snapshot;
+}
+
+QSharedPointer<ScreenSnapshot> Terminal::takeSnapshot()
+{
+    QMutexLocker locker(&_snapshotLock);
+    QSharedPointer<ScreenSnapshot> snapshot = _snapshot;
+    _snapshot.clear();
+    return snapshot;
+}
+
+void Terminal::ringBell()
+{
+    // On the GUI thread, where the view clears the flag again
+    setHasMessage();
+    qApp->beep();
 }
 
 void Terminal::handleNormalDataInput(uchar c)
 {
+    PROFILE_PARSER(HandlerNormal);
     switch (c)
     {
     case ASC_NUL:   // NULL
@@ -337,34 +754,34 @@ void Terminal::handleNormalDataInput(uchar c)
     case ASC_EQT:   // Flow control
         break;
     case ASC_ENQ:   // Flow control...why does this need action?
-        connection()->sendBytes(QByteArray(ASC_NUL));
+        emit hasBytesToSend(QByteArray(ASC_NUL));
         break;
     case ASC_ACK:   // Flow control
         break;
     case ASC_BEL:   // Bell
-        qApp->beep();
-        setHasMessage();
+        emit bell();
         break;
     case ASC_BS:    // Backspace (^H)
         handleNormalBs();
         break;
-    case ASC_HT:    // Horizontal Tab
-        _cursorX = (_cursorX / 8 + 1) * 8;
+    case ASC_HT:    // Horizontal Tab, stops at the last column
+        _cursorX = qMin((_cursorX / 8 + 1) * 8, _column - 1);
         break;
     case ASC_LF:    // Line feed
     case ASC_VT:    // Vertical Tab
     case ASC_FF:    // Form feed
         if (!_lnm)
             _cursorX = 0;
-        goOneRowDown(false);
+        goOneRowDown();
         break;
     case ASC_CR:    // Carriage return
         _cursorX = 0;
         break;
-    case ASC_LS1:   // Locked Shift 1
-    case ASC_LS0:   // Locked Shift 0
-        // These two sets terminal to designated character set
-        // Ignore it for now...
+    case ASC_LS1:   // Locked Shift 1, invoke G1
+        _shift = 1;
+        break;
+    case ASC_LS0:   // Locked Shift 0, invoke G0
+        _shift = 0;
         break;
     case ASC_DLE:   // Normally for modem
     case ASC_DC1:   // XON
@@ -377,14 +794,11 @@ void Terminal::handleNormalDataInput(uchar c)
         break;
     case ASC_CAN:   // Canonical
     case ASC_SUB:   // Substitute
-        // These two can cancel the sequence and display SUB character.
-        // Ignore for now.
+        // These two cancel the sequence in progress (done by the transition
+        // table) and may display a SUB character. Not displayed for now.
         break;
     case ASC_EM:    // ^Y
         break;
-    case ASC_ESC:   // Escape
-        _state = StateEscape;
-        break;
     case ASC_FS:
     case ASC_GS:
     case ASC_RS:
@@ -413,152 +827,104 @@ void Terminal::handleNormalBs()
     }
 }
 
-void Terminal::handleEscapeDataInput(uchar c, int *p_i, const QByteArray &data)
+void Terminal::handleEscapeDataInput(uchar c)
 {
+    PROFILE_PARSER(HandlerEscape);
     switch (c)
     {
-    case ASC_ESC:   // Double Esc
-        _state = StateEscape;
-        break;
-    case ESC_CSI:
-        _csArg->clear();
-        _csBuf->clear();
-        _csTemp = 0;
-        _state = StateControl;
-        break;
     case ESC_RI:    // Scroll down (cursor up)
         goOneRowUp();
-        _state = StateNormal;
         break;
     case ESC_IND:   // Index, scroll up (cursor down)
         goOneRowDown();
-        _state = StateNormal;
         break;
     case ESC_DECSC: // Save cursor
         _savedCursorX = _cursorX;
         _savedCursorY = _cursorY;
-        _state = StateNormal;
-        break;
-    case ESC_DECRC: // Restore cursor
-        _cursorX = _savedCursorX;
-        _cursorY = _savedCursorY;
-        _state = StateNormal;
         break;
-    case ESC_HASH:
-        handleEscapeHash(p_i, data);
-        _state = StateNormal;
-        break;
-    case ESC_sG0:   // Font sets
-    case ESC_sG1:
-        _state = StateScs;
+    case ESC_DECRC: // Restore cursor, or go home if none was saved
+        _cursorX = _savedCursorX >= 0 ? _savedCursorX : 0;
+        _cursorY = _savedCursorY >= 0 ? _savedCursorY : 0;
         break;
     case ESC_APPK:  // Application keyboard mode (vt52)
     case ESC_NUMK:  // Numeric keyboard mode (vt52)
-        _state = StateNormal;
         break;
     case ESC_NEL:   // Next line (CR + Index)
         _cursorX = 0;
         goOneRowDown();
-        _state = StateNormal;
         break;
     case ESC_HTS:   // NOTE: NEED IMPLEMENTATION
-        _state = StateNormal;
         break;
     case ESC_RIS:   // RIS reset
         clearAll();
         _cursorX = 0;
         _cursorY = 0;
-        _state = StateNormal;
+        _charsets[0] = 'B';
+        _charsets[1] = 'B';
+        _shift = 0;
         break;
     default:
-        _state = StateNormal;
         break;
     }
 }
 
-void Terminal::handleEscapeHash(int *p_i, const QByteArray &data)
+void Terminal::handleEscapeIntermediateInput(uchar c)
 {
-    int i = *(p_i);
-    if (i < data.size() - 1 && data[i + 1] == '8')  // DECALN (fill with E)
+    PROFILE_PARSER(HandlerEscape);
+    if (_csParams.intermediateCount() != 1)
+        return;
+    switch (_csParams.intermediate(0))
     {
-        *p_i = i + 1;
-        for (int y = 0; y < _row - 1; y++)
-        {
-            for (int x = 0; x <= _column - 1; x++)
-            {
-                _cells[y][x].byte = 'E';
-                _cells[y][x].attr.v = _emptyAttr;
-                _dirty[y * _column + x] = true;
-            }
-        }
+    case ESC_HASH:
+        handleEscapeHash(c);
+        break;
+    case ESC_sG0:   // Designate G0 character set
+        _charsets[0] = c;
+        break;
+    case ESC_sG1:   // Designate G1 character set
+        _charsets[1] = c;
+        break;
+    default:
+        break;
     }
 }
 
-void Terminal::handleControlDataInput(uchar c)
+void Terminal::handleEscapeHash(uchar c)
 {
-    if (c >= '0' && c <= '?')
+    if (c == '8')   // DECALN (fill with E)
     {
-        _csBuf->enqueue(static_cast<int>(c));
-        if (c >= '0' && c <= '9')
+        BBS::Cell e;
+        e.byte = 'E';
+        e.attr.v = _emptyAttr;
+        for (int y = 0; y < _row; y++)
         {
-            _csTemp = _csTemp * 10 + (c - '0');
-        }
-        else if (c == '?')
-        {
-            _csArg->enqueue(-1);
-            _csTemp = 0;
-            _csBuf->clear();
-        }
-        else if (!_csBuf->isEmpty())
-        {
-            _csArg->enqueue(_csTemp);
-            _csTemp = 0;
-            _csBuf->clear();
-        }
-    }
-    else
-    {
-        switch (c)
-        {
-        case ASC_BS:    // Backspace
-            if (!_csBuf->isEmpty())
-                _csArg->dequeue();
-            break;
-        case ASC_VT:    // Vertical tab
-            if (!_lnm)
-                _cursorX = 0;
-            goOneRowDown(false);
-            break;
-        case ASC_CR:    // Carriage return
-            _cursorX = 0;
-            break;
-        default:
-            handleControlNonSimpleShiftingInputs(c);
-            _csArg->clear();
-            _state = StateNormal;
-            break;
+            std::fill(_cells[y], _cells[y] + _column, e);
+            invalidateBytes(y, 0, _column - 1);
         }
     }
 }
 
 void Terminal::handleControlNonSimpleShiftingInputs(uchar c)
 {
-    if (!_csBuf->isEmpty())
-    {
-        _csArg->enqueue(_csTemp);
-        _csTemp = 0;
-        _csBuf->clear();
-    }
+    PROFILE_PARSER(HandlerCsiDispatch);
+    _csParams.finish();
+
+    // None of the sequences we know take intermediates, and only the modes
+    // have private (DEC) variants. Anything else is ignored as a whole.
+    if (!_csParams.isValid() || _csParams.intermediateCount())
+        return;
+    if (_csParams.prefix() && c != CSI_SM && c != CSI_RM)
+        return;
+
     int p;
     switch (c)
     {
     case CSI_ICH:
-        p = popLineCount();
-        for (int x = _column - 1; x > _cursorX + p - 1; x--)
-        {
-            _cells[_cursorY][x] = _cells[_cursorY][x - p];
-            setDirtyAt(_cursorY, x);
-        }
+        p = qMin(popLineCount(), _column - _cursorX);
+        std::copy_backward(_cells[_cursorY] + _cursorX,
+                           _cells[_cursorY] + _column - p,
+                           _cells[_cursorY] + _column);
+        invalidateBytes(_cursorY, _cursorX, _column - 1);
         clearRow(_cursorY, _cursorX, _cursorX + p - 1);
         break;
     case CSI_CUU:
@@ -685,7 +1051,8 @@ void Terminal::handleControlNonSimpleShiftingInputs(uchar c)
 
 void Terminal::handleControlCup()
 {
-    if (_csArg->isEmpty())
+    PROFILE_PARSER(HandlerCup);
+    if (_csParams.isEmpty())
     {
         _cursorX = 0;
         _cursorY = 0;
@@ -706,7 +1073,8 @@ void Terminal::handleControlCup()
 
 void Terminal::handleControlEd()
 {
-    if (_csArg->isEmpty() || _csArg->head() == 0)
+    PROFILE_PARSER(HandlerEd);
+    if (_csParams.isEmpty() || _csParams.head() == 0)
     {
         clearRow(_cursorY, _cursorX, _column - 1);
         for (int y = _cursorY + 1; y < _row; y++)
@@ -714,7 +1082,7 @@ void Terminal::handleControlEd()
     }
     else
     {
-        switch (_csArg->head())
+        switch (_csParams.head())
         {
         case 1:
             clearRow(_cursorY, 0, _cursorX);
@@ -732,13 +1100,14 @@ void Terminal::handleControlEd()
 
 void Terminal::handleControlEl()
 {
-    if (_csArg->isEmpty() || _csArg->head() == 0)
+    PROFILE_PARSER(HandlerEl);
+    if (_csParams.isEmpty() || _csParams.head() == 0)
     {
         clearRow(_cursorY, _cursorX, _column - 1);
     }
     else
     {
-        switch (_csArg->head())
+        switch (_csParams.head())
         {
         case 1:
             clearRow(_cursorY, 0, _cursorX);
@@ -754,51 +1123,39 @@ void Terminal::handleControlEl()
 
 void Terminal::handleControlIl()
 {
+    PROFILE_PARSER(HandlerIl);
     int lineNum = popLineCount();
-    for (int l = 0; l < lineNum; l++)
-    {
-        clearRow(_scrollEndRow);
-        BBS::Cell *emptyLine = cellsAtRow(_scrollEndRow);
-        for (int y = _scrollEndRow; y > _cursorY; y--)
-            _cells[y] = _cells[y - 1];
-        _cells[_cursorY] = emptyLine;
-    }
-    for (int l = _cursorY; l <= _scrollEndRow; l++)
-        setDirtyUnder(l);
+
+    // Lines outside the scroll region are never moved
+    if (_cursorY < _scrollBeginRow || _cursorY > _scrollEndRow)
+        return;
+    scrollRows(_cursorY, _scrollEndRow, -lineNum);
 }
 
 void Terminal::handleControlDl()
 {
+    PROFILE_PARSER(HandlerDl);
     int lineNum = popLineCount();
-    for (int l = 0; l < lineNum; l++)
-    {
-        clearRow(_cursorY);
-        BBS::Cell *emptyLine = cellsAtRow(_cursorY);
-        for (int y = _cursorY; y < _scrollEndRow; y++)
-            _cells[y] = _cells[y + 1];
-        _cells[_scrollEndRow] = emptyLine;
-    }
-    for (int l = _cursorY; l <= _scrollEndRow; l++)
-        setDirtyUnder(l);
+
+    // Lines outside the scroll region are never moved
+    if (_cursorY < _scrollBeginRow || _cursorY > _scrollEndRow)
+        return;
+    scrollRows(_cursorY, _scrollEndRow, lineNum);
 }
 
 void Terminal::handleControlDch()
 {
-    int p = _csArg->size() == 1 ? popLineCount() : 1;
-    for (int x = _cursorX; x <= _column - 1; x++)
-    {
-        if (x <= _column - 1 - p)
-        {
-            _cells[_cursorY][x] = _cells[_cursorY][x + p];
-        }
-        else
-        {
-            _cells[_cursorY][x].byte = '\0';
-            _cells[_cursorY][x].attr.v = _emptyAttr;
-            _cells[_cursorY][x].attr.f.bColorIndex = _bColorIndex;
-        }
-        setDirtyAt(_cursorY, x);
-    }
+    PROFILE_PARSER(HandlerDch);
+    int p = _csParams.size() == 1 ? popLineCount() : 1;
+    p = qMin(p, _column - _cursorX);
+    BBS::Cell *cells = _cells[_cursorY];
+    BBS::Cell blank;
+    blank.byte = '\0';
+    blank.attr.v = _emptyAttr;
+    blank.attr.f.bColorIndex = _bColorIndex;
+    std::copy(cells + _cursorX + p, cells + _column, cells + _cursorX);
+    std::fill(cells + _column - p, cells + _column, blank);
+    invalidateBytes(_cursorY, _cursorX, _column - 1);
 }
 
 void Terminal::handleControlDa()
@@ -817,66 +1174,67 @@ void Terminal::handleControlDa()
     default:
         break;
     }
-    if (_csArg->isEmpty())
-        connection()->sendBytes(cmd);
-    else if (_csArg->size() == 1 && _csArg->dequeue() == 0)
-        connection()->sendBytes(cmd);
+    if (_csParams.isEmpty())
+        emit hasBytesToSend(cmd);
+    else if (_csParams.size() == 1 && _csParams.dequeue() == 0)
+        emit hasBytesToSend(cmd);
 }
 
 void Terminal::handleControlSm()
 {
+    PROFILE_PARSER(HandlerMode);
     bool clear = false;
-    while (!_csArg->isEmpty())
+    while (!_csParams.isEmpty())
     {
-        int p = _csArg->dequeue();
-        switch (p)
+        int p = _csParams.dequeue();
+        if (!_csParams.prefix())
         {
-        case 20:    // Set mew line mode
-            _lnm = false;
-            break;
-        case 4:     // Set to INSERT mode
-            _irm = true;
-            break;
-        case 1:     // Cursor key send ESC 0 prefix instead of ESC [
-        case 2:     // Keyboard action mode
-        case 6:     // Erasure
-        case 12:    // SRM
-            break;
-        case -1:
-            if (_csArg->size() == 1)
+            switch (p)
             {
-                p = _csArg->dequeue();
-                switch (p)
+            case 20:    // Set mew line mode
+                _lnm = false;
+                break;
+            case 4:     // Set to INSERT mode
+                _irm = true;
+                break;
+            case 1:     // Cursor key send ESC 0 prefix instead of ESC [
+            case 2:     // Keyboard action mode
+            case 6:     // Erasure
+            case 12:    // SRM
+                break;
+            default:
+                break;
+            }
+        }
+        else if (_csParams.prefix() == '?')
+        {
+            switch (p)
+            {
+            case 3:     // Set number of columns to 132
+                clear = true;
+                _originRelative = false;
+                _scrollBeginRow = 0;
+                _scrollEndRow = _row - 1;
+                break;
+            case 5:     // Reverse
+                if (!_screenReverse)
                 {
-                case 3:     // Set number of columns to 132
-                    clear = true;
-                    _originRelative = false;
-                    _scrollBeginRow = 0;
-                    _scrollEndRow = _row - 1;
-                    break;
-                case 5:     // Reverse
-                    if (!_screenReverse)
-                    {
-                        _screenReverse = true;
-                        _reversed = !_reversed;
-                        reverseAll();
-                    }
-                    break;
-                case 6:     // Relative origin
-                    _originRelative = true;
-                    break;
-                case 7:     // Auto-wrap
-                    _autowrap = true;
-                case 1:     // Set cursor key to application
-                case 4:     // Smooth scrolling
-                case 8:     // Auto-repeating
-                case 9:     // Interlacing
-                    break;
+                    _screenReverse = true;
+                    _reversed = !_reversed;
+                    reverseAll();
                 }
+                break;
+            case 6:     // Relative origin
+                _originRelative = true;
+                break;
+            case 7:     // Auto-wrap
+                _autowrap = true;
+            case 1:     // Set cursor key to application
+            case 4:     // Smooth scrolling
+            case 8:     // Auto-repeating
+            case 9:     // Interlacing
+                break;
             }
-            break;
-        default:
-            break;
         }
     }
     if (clear)
@@ -892,60 +1250,61 @@ void Terminal::handleControlSm()
 
 void Terminal::handleControlRm()
 {
+    PROFILE_PARSER(HandlerMode);
     bool clear = false;
-    while (!_csArg->isEmpty())
+    while (!_csParams.isEmpty())
     {
-        int p = _csArg->dequeue();
-        switch (p)
+        int p = _csParams.dequeue();
+        if (!_csParams.prefix())
         {
-        case 20:    // Set mew line mode
-            _lnm = true;
-            break;
-        case 4:     // Set to INSERT mode
-            _irm = false;
-            break;
-        case 1:     // Cursor key send ESC 0 prefix instead of ESC [
-        case 2:     // Keyboard action mode
-        case 6:     // Erasure
-        case 12:    // SRM
-            break;
-        case -1:
-            if (_csArg->size() == 1)
+            switch (p)
+            {
+            case 20:    // Set mew line mode
+                _lnm = true;
+                break;
+            case 4:     // Set to INSERT mode
+                _irm = false;
+                break;
+            case 1:     // Cursor key send ESC 0 prefix instead of ESC [
+            case 2:     // Keyboard action mode
+            case 6:     // Erasure
+            case 12:    // SRM
+                break;
+            default:
+                break;
+            }
+        }
+        else if (_csParams.prefix() == '?')
+        {
+            switch (p)
             {
-                p = _csArg->dequeue();
-                switch (p)
+            case 3:     // Number of columns reset is not supported
+                clear = true;
+                _originRelative = false;
+                _scrollBeginRow = 0;
+                _scrollEndRow = _row - 1;
+                break;
+            case 5:     // Reverse
+                if (_screenReverse)
                 {
-                case 3:     // Number of columns reset is not supported
-                    clear = true;
-                    _originRelative = false;
-                    _scrollBeginRow = 0;
-                    _scrollEndRow = _row - 1;
-                    break;
-                case 5:     // Reverse
-                    if (_screenReverse)
-                    {
-                        _screenReverse = false;
-                        _reversed = !_reversed;
-                        reverseAll();
-                    }
-                    break;
-                case 6:     // Relative origin
-                    _originRelative = false;
-                    break;
-                case 7:     // Auto-wrap
-                    _autowrap = false;
-                case 1:     // Set cursor key to application
-                case 4:     // Smooth scrolling
-                case 8:     // Auto-repeating
-                case 9:     // Interlacing
-                    break;
-                default:
-                    break;
+                    _screenReverse = false;
+                    _reversed = !_reversed;
+                    reverseAll();
                 }
+                break;
+            case 6:     // Relative origin
+                _originRelative = false;
+                break;
+            case 7:     // Auto-wrap
+                _autowrap = false;
+            case 1:     // Set cursor key to application
+            case 4:     // Smooth scrolling
+            case 8:     // Auto-repeating
+            case 9:     // Interlacing
+                break;
+            default:
+                break;
             }
-            break;
-        default:
-            break;
         }
     }
     if (clear)
@@ -958,12 +1317,11 @@ void Terminal::handleControlRm()
 
 void Terminal::handleControlSgr()
 {
-    if (_csArg->isEmpty())  // No parameters means clear, same as 0
-        _csArg->enqueue(0);
-
-    while (!_csArg->isEmpty())
+    PROFILE_PARSER(HandlerSgr);
+    do
     {
-        int p = _csArg->dequeue();
+        // No parameters means clear, same as 0
+        int p = _csParams.isEmpty() ? 0 : _csParams.dequeue();
         switch (p)
         {
         case 0:
@@ -977,8 +1335,9 @@ void Terminal::handleControlSgr()
         case 1:
             _bright = true;
             break;
-        case 4:
-            _underlined = true;
+        case 4:     // 4:0 turns underline off, 4:n picks a style
+            _underlined = !_csParams.headIsSubParameter() ||
+                          _csParams.head() != 0;
             break;
         case 5:
             _blinking = true;
@@ -986,6 +1345,16 @@ void Terminal::handleControlSgr()
         case 7:
             _reversed = true ^ _screenReverse;
             break;
+        case 38:    // Extended foreground color
+            p = popExtendedColor();
+            if (p >= 0)
+                _fColorIndex = p;
+            break;
+        case 48:    // Extended background color
+            p = popExtendedColor();
+            if (p >= 0)
+                _bColorIndex = p;
+            break;
         default:
             switch (p / 10)
             {
@@ -1000,22 +1369,48 @@ void Terminal::handleControlSgr()
             }
             break;
         }
+        _csParams.skipSubParameters();
+    } while (!_csParams.isEmpty());
+}
+
+int Terminal::popExtendedColor()
+{
+    // Consumes the color spec following SGR 38/48, either as sub-parameters
+    // (38:5:n, 38:2:[id]:r:g:b) or as plain ones (38;5;n, 38;2;r;g;b), so the
+    // components are not mistaken for attributes. Only the first eight
+    // indexed colors map onto our palette; -1 means there is nothing to set.
+    if (_csParams.isEmpty())
+        return -1;
+    bool isSub = _csParams.headIsSubParameter();
+    int color = -1;
+    int mode = _csParams.dequeue();
+    if (mode == 5 && !_csParams.isEmpty())
+    {
+        int index = _csParams.dequeue();
+        if (index < 8)
+            color = index;
+    }
+    else if (mode == 2 && !isSub)
+    {
+        for (int i = 0; i < 3 && !_csParams.isEmpty(); i++)
+            _csParams.dequeue();
     }
+    return color;
 }
 
 void Terminal::handleControlDsr()
 {
-    if (_csArg->size() != 1)
+    if (_csParams.size() != 1)
         return;
 
-    int p = _csArg->dequeue();
+    int p = _csParams.dequeue();
     QByteArray cmd;
     switch (p)
     {
     case 5:     // Report device OK (\x1b = ESC)
         cmd.append('\x1b');
         cmd.append("[;0n");
-        connection()->sendBytes(cmd);
+        emit hasBytesToSend(cmd);
         break;
     case 6:     // Report cursor ESC[{y};{x}R  ({x}, {y} indicate position)
         cmd.append('\x1b');
@@ -1028,7 +1423,7 @@ void Terminal::handleControlDsr()
             cmd.append('0' + ((_cursorX + 1) / 10));
         cmd.append('0' + (_cursorX + 1) % 10);
         cmd.append('R');
-        connection()->sendBytes(cmd);
+        emit hasBytesToSend(cmd);
         break;
     default:
         break;
@@ -1037,133 +1432,28 @@ void Terminal::handleControlDsr()
 
 void Terminal::handleControlDecstbm()
 {
-    if (_csArg->isEmpty())
-    {
-        _scrollBeginRow = 0;
-        _scrollEndRow = _row - 1;
-    }
-    else if (_csArg->size() == 2)
+    PROFILE_PARSER(HandlerDecstbm);
+    // Omitted or zero margins default to the screen edges
+    int small = _csParams.isEmpty() ? 0 : _csParams.dequeue();
+    int large = _csParams.isEmpty() ? 0 : _csParams.dequeue();
+    if (small < 1)
+        small = 1;
+    else if (small > _row)
+        small = _row;
+    if (large < 1 || large > _row)
+        large = _row;
+    if (small > large)  // Swap
     {
-        int small = _csArg->dequeue();
-        int large = _csArg->dequeue();
-        if (small > large)  // Swap
-        {
-            int t = small;
-            small = large;
-            large = t;
-        }
-        _scrollBeginRow = small - 1;
-        _scrollEndRow = large - 1;
+        int t = small;
+        small = large;
+        large = t;
     }
+    _scrollBeginRow = small - 1;
+    _scrollEndRow = large - 1;
     _cursorX = 0;
     _cursorY = _scrollBeginRow;
 }
 
-QString Terminal::stringFromIndex(int begin, int length)
-{
-    QString string;
-    uint temp = 0;
-    int space = 0;
-    for (int i = begin; i < begin + length; i++)
-    {
-        int x = i % _column;
-        int y = i / _column;
-        if (x == 0 && i != begin && i - 1 < begin + length) // newline
-        {
-            updateDoubleByteStateForRow(y);
-            string.append(QChar('\n'));
-            space = 0;
-        }
-        BBS::Cell &cell = _cells[y][x];
-        switch (cell.attr.f.doubleByte)
-        {
-        case 0:
-            if (cell.byte == '\0' || cell.byte == ' ')
-            {
-                space++;
-            }
-            else
-            {
-                for (int j = 0; j < space; j++)
-                    string.append(QChar(' '));
-                string.append(QChar(cell.byte));
-                space = 0;
-            }
-            break;
-        case 1:
-            temp = cell.byte;
-            break;
-        case 2:
-            if (temp != 0)
-            {
-                uint code = (temp << 8) + cell.byte - 0x8000;
-                QChar c;
-                switch (connection()->site()->encoding())
-                {
-                case BBS::EncodingBig5:
-                    c = QChar(YL::B2U[code]);
-                    break;
-                case BBS::EncodingGBK:
-                    c = QChar(YL::G2U[code]);
-                    break;
-                default:
-                    c = QChar();
-                    break;
-                }
-                for (int j = 0; j < space; j++)
-                    string.append(QChar(' '));
-                string.append(c);
-                space = 0;
-            }
-            break;
-        }
-    }
-    return string;
-}
-
-QString Terminal::urlStringAt(int row, int column, bool *hasUrl)
-{
-    *hasUrl = _cells[row][column].attr.f.isUrl;
-    if (!*hasUrl)
-        return QString();
-
-    // Find the head of the string
-    while (_cells[row][column].attr.f.isUrl)
-    {
-        column--;
-        if (column < 0)
-        {
-            column = _column - 1;
-            row--;
-        }
-        if (row < 0)
-            break;
-    }
-
-    // Set to the first character
-    column++;
-    if (column >= _column)
-    {
-        column = 0;
-        row++;
-    }
-
-    QString url;
-    while (_cells[row][column].attr.f.isUrl)
-    {
-        url.append(_cells[row][column].byte);
-        column++;
-        if (column >= _column)
-        {
-            column = 0;
-            row++;
-        }
-        if (row >= _row)
-            break;
-    }
-    return url;
-}
-
 BBS::Encoding Terminal::encoding() const
 {
     return connection()->site()->encoding();
@@ -1177,14 +1467,18 @@ void Terminal::setEncoding(BBS::Encoding encoding)
 void Terminal::setConnection(AbstractConnection *connection)
 {
     if (_connection)
+    {
+        _connection->setSink(0);
         _connection->deleteLater();
+    }
     _connection = connection;
     if (!_connection)
         return;
+    _connection->setSink(this);
     connect(_connection, SIGNAL(connected()), this, SLOT(startConnection()));
     connect(_connection, SIGNAL(disconnected()), this, SLOT(closeConnection()));
-    connect(_connection, SIGNAL(processedBytes(QByteArray)),
-            this, SLOT(processIncomingData(QByteArray)));
+    connect(this, SIGNAL(hasBytesToSend(QByteArray)),
+            _connection, SLOT(sendBytes(QByteArray)));
 }
 
 }   // namespace Connection
@@ -20,9 +20,18 @@
 #define TERMINAL_H
 
 #include <QObject>
-#include <QQueue>
+#include <QList>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QVector>
+#include <QWaitCondition>
+#include "CsiParameters.h"
+#include "DataSink.h"
 #include "Globals.h"
+#include "ScreenSnapshot.h"
 #include "YLTerminal.h"
+class TerminalBenchmarker;
+class TerminalChecker;
 
 namespace UJ
 {
@@ -37,61 +46,188 @@ namespace Connection
 
 class AbstractConnection;
 
-class Terminal : public QObject
+// Data from the connection is parsed on a shared thread pool, one batch at a
+// time per terminal, so that a flood of data never holds up the GUI thread.
+// The connection hands it over as the terminal's DataSink, and the chunks of
+// a batch are queued for the parser together when the batch ends.
+// After each batch the terminal publishes a ScreenSnapshot and emits
+// dataProcessed(); the view takes the snapshot with takeSnapshot() and draws
+// from that, never from the terminal itself.
+//
+// Whatever a parsed sequence has to do on the GUI thread, like replying to
+// the server or ringing the bell, goes there through a signal.
+class Terminal : public QObject, public DataSink
 {
     Q_OBJECT
+    friend class ::TerminalBenchmarker;
+    friend class ::TerminalChecker;
 
 public:
     explicit Terminal(QObject *parent = 0);
     virtual ~Terminal();
-    inline bool isDiryAt(int row, int column)
-    {
-        return _dirty[row * _column + column];
-    }
-    inline BBS::CellAttribute attributeOfCellAt(int row, int column)
-    {
-        return _cells[row][column].attr;
-    }
-    inline BBS::Cell *cellsAtRow(int row)
-    {
-        return _cells[row];
-    }
-    QString stringFromIndex(int begin, int length);
-    QString urlStringAt(int row, int column, bool *haUrl);
+    QSharedPointer<ScreenSnapshot> takeSnapshot();
+
+    // DataSink
+    virtual void receiveData(const QByteArray &bytes);
+    virtual void endBatch();
 
 signals:
     void dataProcessed();
-    void shouldExtendTop(int start, int end);
-    void shouldExtendBottom(int start, int end);
+    void hasBytesToSend(QByteArray bytes);
+    void bell();
 
 public slots:
     void startConnection();
     void closeConnection();
+    void queueIncomingData(QByteArray bytes);
+
+private slots:
+    void ringBell();
+
+private:
+    // Everything from here on is the parser's, and only touched by the task
+    // parsing this terminal, or while none is. The GUI thread reads the
+    // screen from snapshots instead. The benchmark and its checker are
+    // friends, so they can drive the parser directly on their own thread.
     void processIncomingData(QByteArray bytes);
     void clearAll();
     void clearRow(int row,
                   int columnStart = 0, int columnEnd = PositionNotFound);
+    inline bool isDiryAt(int row, int column)
+    {
+        return column >= _dirtyBegin[row] && column < _dirtyEnd[row];
+    }
+    inline bool isDirty() const
+    {
+        return _dirtyRowCount > 0;
+    }
+    inline bool isDirtyRow(int row) const
+    {
+        return _dirtyBegin[row] < _dirtyEnd[row];
+    }
+    // Columns [dirtyBeginAt(), dirtyEndAt()) of the row need repainting
+    inline int dirtyBeginAt(int row) const
+    {
+        return _dirtyBegin[row];
+    }
+    inline int dirtyEndAt(int row) const
+    {
+        return _dirtyEnd[row];
+    }
     inline void setDirtyAll()
     {
         setDirtyUnder(0);
     }
     inline void setDirtyUnder(int row, bool dirty = true)
     {
-        for (int i = row * _column; i < _row * _column; i++)
-            _dirty[i] = dirty;
+        for (int y = row; y < _row; y++)
+            setDirtyRow(y, dirty);
+    }
+    inline void setDirtyRow(int row, bool dirty = true)
+    {
+        if (dirty)
+        {
+            setDirtySpan(row, 0, _column);
+        }
+        else if (isDirtyRow(row))
+        {
+            _dirtyBegin[row] = _column;
+            _dirtyEnd[row] = 0;
+            _dirtyRowCount--;
+        }
+    }
+    inline void setDirtySpan(int row, int begin, int end)
+    {
+        if (begin >= end)
+            return;
+        if (!isDirtyRow(row))
+            _dirtyRowCount++;
+        if (begin < _dirtyBegin[row])
+            _dirtyBegin[row] = begin;
+        if (end > _dirtyEnd[row])
+            _dirtyEnd[row] = end;
+    }
+    inline void setDirtyAt(int row, int column)
+    {
+        setDirtySpan(row, column, column + 1);
+    }
+    inline BBS::CellAttribute attributeOfCellAt(int row, int column)
+    {
+        return _cells[row][column].attr;
+    }
+    // 1 for the lead byte of a double-byte character, 2 for the trail byte,
+    // 0 otherwise (including positions off the screen). Kept up to date
+    // after each chunk of data, so this is just a lookup.
+    inline int doubleByteStateAt(int row, int column) const
+    {
+        if (column < 0 || column >= _column)
+            return 0;
+        return _cells[row][column].attr.f.doubleByte;
+    }
+    // Rows scroll by moving what is kept for them, not their cells. The
+    // origin of a row is the row it was at when clearRowMoves() was last
+    // called (when the last snapshot was published), or -1 if it has been
+    // blanked by a scroll since. A view can copy the pixels of moved rows
+    // instead of painting them again.
+    inline bool hasMovedRows() const
+    {
+        return _hasMovedRows;
     }
-    inline void setDirtyAt(int row, int column, bool dirty = true)
+    inline int rowOriginAt(int row) const
     {
-        _dirty[row * _column + column] = dirty;
+        return _rowOrigins[row];
+    }
+    inline BBS::Cell *cellsAtRow(int row)
+    {
+        return _cells[row];
+    }
+    inline const QVector<UrlSpan> &urlSpansAtRow(int row) const
+    {
+        return _urlRows[row].spans;
+    }
+    inline int cursorRow() const
+    {
+        return _cursorY;
+    }
+    inline void setCursorRow(int row)
+    {
+        _cursorY = row;
+    }
+    inline int cursorColumn() const
+    {
+        return _cursorX;
+    }
+    inline void setCursorColumn(int column)
+    {
+        _cursorX = column;
+    }
+    inline uchar charset() const
+    {
+        return _charsets[_shift];
     }
     void reverseAll();
-    void updateUrlStateForRow(int row);
+    void updateUrlStateForRows();
     void updateDoubleByteStateForRow(int row);
+    void clearRowMoves();
 
-private:
+    class ParseTask;
+    void parseQueuedData();
+    void waitForParser();
+    void publish();
     void initSettings();
     void initCells();
     void setByteUnderCursor(uchar c);
+    void setBytesUnderCursor(const uchar *bytes, int length);
+    inline void invalidateBytes(int row, int begin, int end)
+    {
+        setDirtySpan(row, begin, end + 1);
+        if (begin < _doubleByteBegin[row])
+            _doubleByteBegin[row] = begin;
+        if (end > _doubleByteEnd[row])
+            _doubleByteEnd[row] = end;
+        _urlRows[row].dirty = true;
+    }
+    void updateUrlStateForRow(int row, bool continued);
     inline void moveCursorTo(int x, int y)
     {
         _cursorX = x < 0 ? 0 : (x >= _column ? _column - 1 : x);
@@ -99,18 +235,19 @@ private:
     }
     inline int popLineCount()
     {
-        if (_csArg->isEmpty())
+        if (_csParams.isEmpty())
             return 1;
-        int p = _csArg->dequeue();
+        int p = _csParams.dequeue();
         return (p > 1 ? p : 1);
     }
-    void goOneRowUp(bool updateView = true);
-    void goOneRowDown(bool updateView = true);
+    void goOneRowUp();
+    void goOneRowDown();
+    void scrollRows(int first, int last, int count);
     void handleNormalDataInput(uchar c);
-    void handleEscapeDataInput(uchar c, int *p_i, const QByteArray &data);
-    void handleControlDataInput(uchar c);
+    void handleEscapeDataInput(uchar c);
+    void handleEscapeIntermediateInput(uchar c);
     void handleNormalBs();
-    void handleEscapeHash(int *p_i, const QByteArray &data);
+    void handleEscapeHash(uchar c);
     void handleControlNonSimpleShiftingInputs(uchar c);
     void handleControlCup();
     void handleControlEd();
@@ -122,14 +259,22 @@ private:
     void handleControlSm();
     void handleControlRm();
     void handleControlSgr();
+    int popExtendedColor();
     void handleControlDsr();
     void handleControlDecstbm();
 
     Qelly::View *_view;
     AbstractConnection *_connection;
-    QQueue<int> *_csArg;
-    QQueue<int> *_csBuf;
-    uint _csTemp;
+
+    QList<QByteArray> _received;    // This batch, on the GUI thread
+    QMutex _inputLock;              // Guards the three below
+    QList<QByteArray> _input;       // Received and not yet parsed
+    bool _parsing;                  // A task is parsing this terminal
+    QWaitCondition _parserIdle;
+    QMutex _snapshotLock;
+    QSharedPointer<ScreenSnapshot> _snapshot;   // Published, not yet taken
+
+    CsiParameters _csParams;
     ushort _emptyAttr;
 
     int _row;
@@ -150,8 +295,26 @@ private:
     bool _blinking;
     bool _reversed;
 
-    BBS::Cell **_cells;
-    int *_dirty;
+    BBS::Cell *_screen;     // All rows, in one allocation
+    BBS::Cell **_cells;     // Start of each row in _screen
+    int *_dirtyBegin;       // Columns of each row that need repainting;
+    int *_dirtyEnd;         // begin >= end if there are none
+    int _dirtyRowCount;
+    int *_doubleByteBegin;  // Columns of each row whose bytes changed since
+    int *_doubleByteEnd;    // its double-byte state was last worked out
+
+    // URLs found in each row. These move along with the rows in _cells.
+    struct UrlRow
+    {
+        QVector<UrlSpan> spans;
+        bool dirty;         // Bytes changed since the row was last scanned
+        bool continued;     // The scan started inside a URL
+        bool continues;     // A URL runs off the end of the row
+    };
+    UrlRow *_urlRows;
+
+    int *_rowOrigins;
+    bool _hasMovedRows;
 
     bool _screenReverse;  // reverse (true), not reverse (false, default)
     bool _originRelative; // relative origin (true), absolute (false, default)
@@ -159,13 +322,25 @@ private:
     bool _lnm;            // line feed (true, default), new line (false)
     bool _irm;            // insert (true), replace (false, default)
 
+    // Parser states, after the DEC ANSI parser model. Each input byte is
+    // looked up in _transitions to get an action and the next state, so a
+    // sequence may be split across chunks anywhere.
     enum State
     {
         StateNormal,
         StateEscape,
-        StateControl,
-        StateScs
+        StateEscapeIntermediate,    // ESC #, ESC (, ESC ) and the like
+        StateControl,               // CSI parameters
+        StateControlIntermediate,
+        StateControlIgnore,         // Malformed CSI, skipped to its end
+        StateString,                // DCS, OSC, SOS, PM, APC; discarded
+        StateCount
     } _state;
+    struct Transitions;
+    static const Transitions _transitions;
+
+    uchar _charsets[2];     // Final bytes designating G0 and G1 ('B' ASCII)
+    int _shift;             // Invoked set, G0 (SI, default) or G1 (SO)
 
     enum Standard
     {
@@ -174,22 +349,6 @@ private:
     } _standard;
 
 public: // Setters & Getters
-    inline int cursorRow() const
-    {
-        return _cursorY;
-    }
-    inline void setCursorRow(int row)
-    {
-        _cursorY = row;
-    }
-    inline int cursorColumn() const
-    {
-        return _cursorX;
-    }
-    inline void setCursorColumn(int column)
-    {
-        _cursorX = column;
-    }
     BBS::Encoding encoding() const;
     void setEncoding(BBS::Encoding encoding);
     inline bool hasMessage() const
@@ -0,0 +1,169 @@
+/*****************************************************************************
+ * UJByteScan.cpp
+ *
+ * Created: 16/10 2026 by uranusjr
+ *
+ * Copyright 2026 uranusjr. All rights reserved.
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ *****************************************************************************/
+
+#include "UJByteScan.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+        (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define UJ_BYTESCAN_SSE2
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// AVX2 is picked at runtime, so the code is compiled for it with a target
+// attribute instead of a global -mavx2 (which would break older CPUs).
+// MSVC, clang-cl included, stays on SSE2.
+#if defined(UJ_BYTESCAN_SSE2) && !defined(_MSC_VER) && \
+        (defined(__clang__) || (defined(__GNUC__) && \
+         (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+#define UJ_BYTESCAN_AVX2
+#include <immintrin.h>
+#endif
+
+namespace UJ
+{
+
+namespace
+{
+
+int scanScalar(const uchar *data, int size)
+{
+    int i = 0;
+    while (i < size && isPrintableByte(data[i]))
+        i++;
+    return i;
+}
+
+#ifdef UJ_BYTESCAN_SSE2
+
+inline int firstSetBit(uint mask)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return index;
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+int scanSse2(const uchar *data, int size)
+{
+    // There is no unsigned byte comparison in SSE2; c <= 0x1f is the same as
+    // min(c, 0x1f) == c.
+    const __m128i controlMax = _mm_set1_epi8(0x1f);
+    const __m128i del = _mm_set1_epi8(0x7f);
+    int i = 0;
+    for (; i + 16 <= size; i += 16)
+    {
+        __m128i v = _mm_loadu_si128(
+                    reinterpret_cast<const __m128i *>(data + i));
+        __m128i stop = _mm_or_si128(
+                    _mm_cmpeq_epi8(_mm_min_epu8(v, controlMax), v),
+                    _mm_cmpeq_epi8(v, del));
+        uint mask = _mm_movemask_epi8(stop);
+        if (mask)
+            return i + firstSetBit(mask);
+    }
+    return i + scanScalar(data + i, size - i);
+}
+
+int runBeforeSse2(const uchar *data, int size, uchar a, uchar b)
+{
+    const __m128i first = _mm_set1_epi8(a);
+    const __m128i second = _mm_set1_epi8(b);
+    int i = 0;
+    for (; i + 16 <= size; i += 16)
+    {
+        __m128i v = _mm_loadu_si128(
+                    reinterpret_cast<const __m128i *>(data + i));
+        __m128i stop = _mm_or_si128(_mm_cmpeq_epi8(v, first),
+                                    _mm_cmpeq_epi8(v, second));
+        uint mask = _mm_movemask_epi8(stop);
+        if (mask)
+            return i + firstSetBit(mask);
+    }
+    while (i < size && data[i] != a && data[i] != b)
+        i++;
+    return i;
+}
+
+#endif // UJ_BYTESCAN_SSE2
+
+#ifdef UJ_BYTESCAN_AVX2
+
+__attribute__((target("avx2")))
+int scanAvx2(const uchar *data, int size)
+{
+    const __m256i controlMax = _mm256_set1_epi8(0x1f);
+    const __m256i del = _mm256_set1_epi8(0x7f);
+    int i = 0;
+    for (; i + 32 <= size; i += 32)
+    {
+        __m256i v = _mm256_loadu_si256(
+                    reinterpret_cast<const __m256i *>(data + i));
+        __m256i stop = _mm256_or_si256(
+                    _mm256_cmpeq_epi8(_mm256_min_epu8(v, controlMax), v),
+                    _mm256_cmpeq_epi8(v, del));
+        uint mask = _mm256_movemask_epi8(stop);
+        if (mask)
+            return i + __builtin_ctz(mask);
+    }
+    return i + scanSse2(data + i, size - i);
+}
+
+#endif // UJ_BYTESCAN_AVX2
+
+typedef int (*ScanFunction)(const uchar *, int);
+
+ScanFunction bestScanFunction()
+{
+#if defined(UJ_BYTESCAN_AVX2)
+    if (__builtin_cpu_supports("avx2"))
+        return scanAvx2;
+    return scanSse2;
+#elif defined(UJ_BYTESCAN_SSE2)
+    return scanSse2;
+#else
+    return scanScalar;
+#endif
+}
+
+}   // namespace
+
+int printableRunLength(const uchar *data, int size)
+{
+    static const ScanFunction scan = bestScanFunction();
+    return scan(data, size);
+}
+
+int runLengthBefore(const uchar *data, int size, uchar a, uchar b)
+{
+#ifdef UJ_BYTESCAN_SSE2
+    return runBeforeSse2(data, size, a, b);
+#else
+    int i = 0;
+    while (i < size && data[i] != a && data[i] != b)
+        i++;
+    return i;
+#endif
+}
+
+}   // namespace UJ
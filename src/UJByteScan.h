@@ -0,0 +1,44 @@
+/*****************************************************************************
+ * UJByteScan.h
+ *
+ * Created: 16/10 2026 by uranusjr
+ *
+ * Copyright 2026 uranusjr. All rights reserved.
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ *****************************************************************************/
+
+#ifndef UJBYTESCAN_H
+#define UJBYTESCAN_H
+
+#include <QtGlobal>
+
+namespace UJ
+{
+
+// Bytes the terminal puts on screen as they are: everything except the C0
+// controls and DEL. Bytes above 0x7f are halves of double-byte characters.
+inline bool isPrintableByte(uchar c)
+{
+    return c >= 0x20 && c != 0x7f;
+}
+
+// Length of the run of printable bytes at the start of data. Uses SSE2, or
+// AVX2 when the CPU has it, falling back to a plain loop elsewhere.
+int printableRunLength(const uchar *data, int size);
+
+// Length of the run at the start of data that has neither byte a nor byte b
+// in it. Uses SSE2 where available.
+int runLengthBefore(const uchar *data, int size, uchar a, uchar b);
+
+}   // namespace UJ
+
+#endif // UJBYTESCAN_H
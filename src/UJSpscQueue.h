@@ -0,0 +1,100 @@
+/*****************************************************************************
+ * UJSpscQueue.h
+ *
+ * Created: 16/10 2026 by uranusjr
+ *
+ * Copyright 2026 uranusjr. All rights reserved.
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ *****************************************************************************/
+
+#ifndef UJSPSCQUEUE_H
+#define UJSPSCQUEUE_H
+
+#include <QAtomicInt>
+
+namespace UJ
+{
+
+// A bounded queue between exactly one producer thread and one consumer
+// thread, without locks. Each side only writes its own index, and stores it
+// with release semantics once the slot it covers is ready, so neither side
+// ever sees a slot the other is still working on. The capacity is rounded up
+// to a power of two.
+template <typename T>
+class SpscQueue
+{
+public:
+    explicit SpscQueue(int capacity) : _head(0), _tail(0)
+    {
+        _size = 1;
+        while (_size < capacity)
+            _size <<= 1;
+        _slots = new T[_size];
+    }
+
+    ~SpscQueue()
+    {
+        delete [] _slots;
+    }
+
+    // Producer side
+    bool isFull()
+    {
+        int tail = _tail.fetchAndAddRelaxed(0);
+        return distance(_head.fetchAndAddAcquire(0), tail) == _size;
+    }
+    bool push(const T &value)
+    {
+        int tail = _tail.fetchAndAddRelaxed(0);
+        if (distance(_head.fetchAndAddAcquire(0), tail) == _size)
+            return false;
+        _slots[tail & (_size - 1)] = value;
+        _tail.fetchAndStoreRelease(next(tail));
+        return true;
+    }
+
+    // Consumer side
+    bool pop(T *value)
+    {
+        int head = _head.fetchAndAddRelaxed(0);
+        if (head == _tail.fetchAndAddAcquire(0))
+            return false;
+        T &slot = _slots[head & (_size - 1)];
+        *value = slot;
+        slot = T();     // Let go of it now rather than when overwritten
+        _head.fetchAndStoreRelease(next(head));
+        return true;
+    }
+
+private:
+    Q_DISABLE_COPY(SpscQueue)
+
+    // Indices run over twice the capacity, so that a full queue and an empty
+    // one can be told apart without a spare slot
+    inline int next(int index) const
+    {
+        return (index + 1) & (2 * _size - 1);
+    }
+    inline int distance(int head, int tail) const
+    {
+        return (tail - head) & (2 * _size - 1);
+    }
+
+    T *_slots;
+    int _size;
+    QAtomicInt _head;   // Next slot to pop; written by the consumer only
+    QAtomicInt _tail;   // Next slot to push; written by the producer only
+};
+
+}   // namespace UJ
+
+#endif // UJSPSCQUEUE_H
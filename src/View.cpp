@@ -35,6 +35,7 @@
 #include "Encodings.h"
 #include "PreeditTextHolder.h"
 #include "SharedPreferences.h"
+#include "ScreenSnapshot.h"
 #include "Site.h"
 #include "Terminal.h"
 
@@ -52,8 +53,9 @@ View::View(QWidget *parent) : Widget(parent)
     setFocusPolicy(Qt::StrongFocus);
     setAttribute(Qt::WA_InputMethodEnabled);
     setAttribute(Qt::WA_KeyCompression, false);     // One key per key event
-    setFixedSize(d->cellWidth * d->column, d->cellHeight * d->row);
-    startTimer(QApplication::cursorFlashTime());    // NOTE: Use preferences
+    connect(d->prefs, SIGNAL(renderSettingsChanged()),
+            this, SLOT(updateScreen()));
+    connect(d->prefs, SIGNAL(renderSettingsChanged()), this, SLOT(update()));
 }
 
 View::~View()
@@ -61,11 +63,27 @@ View::~View()
     delete d_ptr;
 }
 
-void View::timerEvent(QTimerEvent *)
+void View::showEvent(QShowEvent *e)
+{
+    d_ptr->updateBlinkSubscription();
+    Qx::Widget::showEvent(e);
+}
+
+void View::hideEvent(QHideEvent *e)
+{
+    d_ptr->updateBlinkSubscription();
+    Qx::Widget::hideEvent(e);
+}
+
+void View::blink(bool on)
 {
     Q_D(View);
-    d->blinkTicker = !d->blinkTicker;
-    update();
+
+    // Only the blinking cells change
+    d->blinkTicker = on;
+    for (int y = 0; y < d->row; y++)
+        d->damage.addCells(y, d->blinkBegins[y], d->blinkEnds[y]);
+    d->flushDamage();
 }
 
 bool View::focusNextPrevChild(bool)
@@ -92,6 +110,11 @@ void View::clearPreeditHolder()
     d_ptr->hidePreeditHolder();
 }
 
+void View::flushDamage()
+{
+    d_ptr->flushDamage();
+}
+
 void View::mousePressEvent(QMouseEvent *e)
 {
     Q_D(View);
@@ -126,9 +149,8 @@ void View::mouseDoubleClickEvent(QMouseEvent *e)
     {
         int r = d->selectedStart / d->column;
         int c = d->selectedStart % d->column;
-        d->terminal->updateDoubleByteStateForRow(r);
-        BBS::Cell *row = d->terminal->cellsAtRow(r);
-        switch (row[c].attr.f.doubleByte)
+        const BBS::Cell *row = d->screen->cellsAtRow(r);
+        switch (d->screen->doubleByteStateAt(r, c))
         {
         case 1: // First half of double byte
             d->selectedLength = 2;
@@ -146,11 +168,8 @@ void View::mouseDoubleClickEvent(QMouseEvent *e)
         }
 
         // Order redraw for selection region
-        int ox = d->selectedStart % d->column;
-        int oy = d->selectedStart / d->column;
-        int dx = d->cellWidth * d->selectedLength;
-        int dy = d->cellHeight;
-        update(QRect(d->pointFromIndex(ox, oy), QSize(dx, dy)));
+        d->damageIndices(d->selectedStart, d->selectedLength);
+        d->requestRepaint();
     }
 
     return Qx::Widget::mouseDoubleClickEvent(e);
@@ -171,8 +190,8 @@ void View::mouseTripleClickEvent(QMouseEvent *e)
         d->selectedStart = d->selectedStart - (d->selectedStart % d->column);
         d->selectedLength = d->column;
 
-        update(QRect(d->pointFromIndex(0, d->selectedStart / d->column),
-                     QSize(d->column * d->cellWidth, d->cellHeight)));
+        d->damageIndices(d->selectedStart, d->selectedLength);
+        d->requestRepaint();
     }
 
     return Qx::Widget::mouseTripleClickEvent(e);
@@ -201,8 +220,9 @@ void View::mouseMoveEvent(QMouseEvent *e)
                 tail = d->selectedStart > index ? d->selectedStart : index;
             else
                 tail = tail > index ? tail : index;
-            update(0, head / d->column * d->cellHeight,
-                   d->column * d->cellWidth, (tail - head + 1) * d->cellHeight);
+            d->damage.addRows(head / d->column,
+                              tail / d->column - head / d->column + 1);
+            d->requestRepaint();
         }
     }
     return Qx::Widget::mouseMoveEvent(e);
@@ -216,7 +236,7 @@ void View::mouseReleaseEvent(QMouseEvent *e)
     {
         int index = d->indexFromPoint(e->pos());
         bool hasUrl = false;
-        QString url = d->terminal->urlStringAt(
+        QString url = d->screen->urlStringAt(
                     index / d->column, index % d->column, &hasUrl);
         if (hasUrl && e->button() == Qt::LeftButton
                 && !(e->modifiers() & UJ::MOD))
@@ -296,8 +316,8 @@ void View::inputMethodEvent(QInputMethodEvent *e)
         // Put the holder near the cursor. Usually we put it one row above it
         // (with some extra cusion, so it's 1.2 instead of 1), but if the cursor
         // is at row 0 or 1, put it one row UNDER it instead.
-        QPoint p = d->pointFromIndex(d->terminal->cursorColumn(),
-                                     d->terminal->cursorRow());
+        QPoint p = d->pointFromIndex(d->screen->cursorColumn(),
+                                     d->screen->cursorRow());
         if (p.y() <= d->cellHeight * 2)
             p.ry() += d->cellHeight * 1.2;
         else
@@ -414,6 +434,11 @@ Connection::Terminal *View::terminal() const
     return d_ptr->terminal;
 }
 
+FrameScheduler *View::frameScheduler() const
+{
+    return d_ptr->scheduler;
+}
+
 void View::updateScreen()
 {
     Q_D(View);
@@ -421,9 +446,11 @@ void View::updateScreen()
     if (!isConnected())
         return;
 
+    d->takeScreen();
     updateBackImage();
-    int x = d->terminal->cursorColumn();
-    int y = d->terminal->cursorRow();
+    d->updateBlinkSubscription();
+    int x = d->screen->cursorColumn();
+    int y = d->screen->cursorRow();
     if (d->x != x || d->y != y)
     {
         d->displayCellAt(d->x, d->y);   // Un-draw the old cursor
@@ -431,59 +458,85 @@ void View::updateScreen()
         d->y = y;
     }
     d->displayCellAt(d->x, d->y);       // Draw current cursor
+    d->flushDamage();
 }
 
 void View::updateBackImage()
 {
     Q_D(View);
 
+    d->syncRenderSettings();
+    if (d->screen->hasMovedRows())
+        d->moveBackImageRows();
+    if (!d->screen->isDirty())
+        return;
+
+    // One painter session for the whole frame; everything below draws with
+    // it instead of opening its own. A raster back buffer only records what
+    // to draw, and draws it all at the end.
+    if (!d->backRaster)
+        d->painter->begin(d->backImage);
     for (int y = 0; y < d->row; y++)
     {
-        // Background
-        int start = d->column;
-        for (int x = 0; x < d->column; x++)
-        {
-            if (d->terminal->isDiryAt(y, x))
-            {
-                start = x;
-                while (x < d->column && d->terminal->isDiryAt(y, x))
-                    x++;
-                updateBackground(y, start, x);
-            }
-        }
+        if (!d->screen->isDirtyRow(y))
+            continue;
 
-        // Foreground
+        // Repaint whole double-byte characters, or a half left outside the
+        // span would be wiped by the background but not drawn again
+        int begin = d->screen->dirtyBeginAt(y);
+        int end = d->screen->dirtyEndAt(y);
+        if (d->screen->doubleByteStateAt(y, begin) == 2)
+            d->screen->setDirtyAt(y, begin - 1);
+        if (end < d->column && d->screen->doubleByteStateAt(y, end - 1) == 1)
+            d->screen->setDirtyAt(y, end);
+
+        updateBackground(y, d->screen->dirtyBeginAt(y),
+                         d->screen->dirtyEndAt(y));
         updateText(y);
-
-        for (int x = 0; x < d->column; x++)
-            d->terminal->setDirtyAt(y, x, false);
+        d->indexBlinkingCells(y);
+        d->screen->setDirtyRow(y, false);
     }
+    if (d->backRaster)
+        d->backRaster->render();
+    else
+        d->painter->end();
 }
 
 void View::updateBackground(int row, int startColumn, int endColumn)
 {
     Q_D(View);
 
-    BBS::Cell *cells = d->terminal->cellsAtRow(row);
+    // Fill each run of cells sharing a background color at once
+    const BBS::Cell *cells = d->screen->cellsAtRow(row);
     BBS::CellAttribute now;
     BBS::CellAttribute last = cells[startColumn].attr;
     int length = 1;
 
-    d->painter->begin(d->backImage);
     for (int x = startColumn + 1; x <= endColumn; x++)
     {
-        now = cells[x].attr;
-        bool changed = now.f.bColorIndex != last.f.bColorIndex ||
-                       (now.f.reversed & now.f.bright)
-                            != (last.f.reversed & last.f.bright) ||
-                       x == endColumn;
+        bool changed = x == endColumn;
+        if (!changed)
+        {
+            now = cells[x].attr;
+            changed = now.f.bColorIndex != last.f.bColorIndex ||
+                      (now.f.reversed & now.f.bright)
+                            != (last.f.reversed & last.f.bright);
+        }
         if (changed)
         {
-            d->painter->fillRect(
-                        (x - length) * d->cellWidth, row * d->cellHeight,
-                        length * d->cellWidth, d->cellHeight,
-                        d->prefs->bColor(last.f.bColorIndex,
-                                         last.f.reversed && last.f.bright));
+            QRect rect((x - length) * d->cellWidth, row * d->cellHeight,
+                       length * d->cellWidth, d->cellHeight);
+            bool bright = last.f.reversed && last.f.bright;
+            if (d->backRaster)
+            {
+                d->backRaster->fill(rect, d->settings->bColor(
+                                        last.f.bColorIndex, bright));
+            }
+            else
+            {
+                d->painter->fillRect(rect, d->settings->bBrush(
+                                         last.f.bColorIndex, bright));
+            }
             length = 1;
             last = now;
         }
@@ -493,77 +546,80 @@ void View::updateBackground(int row, int startColumn, int endColumn)
         }
     }
 
-    d->painter->end();
-
-    QRect rect(startColumn * d->cellWidth, row * d->cellHeight,
-               (endColumn - startColumn) * d->cellWidth, d->cellHeight);
-    update(rect);
+    d->damage.addCells(row, startColumn, endColumn);
 }
 
 void View::updateText(int row)
 {
     Q_D(View);
 
-    d->terminal->updateDoubleByteStateForRow(row);
-
-    // Find first dirty position
-    int x = 0;
-    while (x < d->column && !d->terminal->isDiryAt(row, x))
-        x++;
-    if (x == d->column)
+    int begin = d->screen->dirtyBeginAt(row);
+    int end = d->screen->dirtyEndAt(row);
+    if (begin >= end)
         return;
 
-    int start = x;
-
-    for (x = start; x < d->column; x++)
-    {
-        if (!d->terminal->isDiryAt(row, x))
-            continue;
-        updateText(row, x);
-    }
-    update((start - 1) *d->cellWidth, row * d->cellHeight,
-           3 * d->cellWidth, d->cellHeight);
-}
+    d->updateText(row, begin, end);
 
-void View::updateText(int row, int x)
-{
-    d_ptr->updateText(row, x);
+    // Glyphs may reach a little into the cells next to them
+    d->damage.addCells(row, begin - 1, end + 1);
 }
 
 void View::paintEvent(QPaintEvent *e)
 {
     Q_D(View);
 
+    d->syncRenderSettings();
     d->painter->begin(this);
     if (isConnected())
     {
         QRect r = e->rect();
 
-        // Draw a portion of back image
-        d->painter->drawPixmap(r.left(), r.top(), *d->backImage,
-                             r.left(), r.top(), r.width(), r.height());
-        d->paintBlink(r);
+        // Draw the damaged portions of back image
+        const QRegion &region = e->region();
+#if QT_VERSION >= QT_VERSION_CHECK(5, 8, 0)
+        QRegion::const_iterator begin = region.begin();
+        QRegion::const_iterator end = region.end();
+#else
+        QVector<QRect> rects = region.rects();
+        QVector<QRect>::const_iterator begin = rects.constBegin();
+        QVector<QRect>::const_iterator end = rects.constEnd();
+#endif
+        for (; begin != end; ++begin)
+        {
+            const QRect &damaged = *begin;
+            if (d->backRaster)
+            {
+                d->painter->drawImage(damaged.topLeft(),
+                                      d->backRaster->image(), damaged);
+            }
+            else
+            {
+                d->painter->drawPixmap(damaged.topLeft(), *d->backImage,
+                                       damaged);
+            }
+            d->paintBlink(damaged);
+        }
 
         // URL line
         // NOTE: Preference for URL color and width
         d->painter->setPen(QPen(QColor("orange"), 1.0));
+        int xBegin = r.left() / d->cellWidth;
+        int xEnd = r.right() / d->cellWidth + 1;
         for (int y = r.top() / d->cellHeight;
-             y <= r.bottom() / d->cellHeight; y++)
+             y <= r.bottom() / d->cellHeight && y < d->row; y++)
         {
-            BBS::Cell *cells = d->terminal->cellsAtRow(y);
-            int xEnd = r.right() / d->cellWidth + 1;
-            for (int x = r.left() / d->cellWidth; x < xEnd; x++)
+            const QVector<Connection::UrlSpan> &spans =
+                    d->screen->urlSpansAtRow(y);
+            for (int i = 0; i < spans.size(); i++)
             {
-                int start = x;
-                while (start < xEnd && cells[x].attr.f.isUrl)
-                    x++;
-                if (start != x)
-                {
-                    // NOTE: Prefernce for URL y offset (the -0.5)
-                    int yPos = (y + 1) * d->cellHeight - 0.5;
-                    d->painter->drawLine(start *d->cellWidth, yPos,
-                                       x * d->cellWidth, yPos);
-                }
+                int start = qMax(spans[i].begin, xBegin);
+                int end = qMin(spans[i].end, xEnd);
+                if (start >= end)
+                    continue;
+                // NOTE: Prefernce for URL y offset (the -0.5)
+                int yPos = (y + 1) * d->cellHeight - 0.5;
+                d->painter->drawLine(start * d->cellWidth, yPos,
+                                     end * d->cellWidth, yPos);
             }
         }
 
@@ -572,8 +628,8 @@ void View::paintEvent(QPaintEvent *e)
         //       Should a non-line type cursor be implemented?
         d->painter->setPen(Qt::NoPen);
         d->painter->setBrush(QBrush(Qt::white, Qt::SolidPattern));
-        d->x = d->terminal->cursorColumn();
-        d->y = d->terminal->cursorRow();
+        d->x = d->screen->cursorColumn();
+        d->y = d->screen->cursorRow();
         // NOTE: Prefernce for cursor y offset (the -2)
         int yPos = (d->y + 1) * d->cellHeight - 2;
         d->painter->drawRect(d->x * d->cellWidth, yPos, d->cellWidth, 2);
@@ -586,49 +642,13 @@ void View::paintEvent(QPaintEvent *e)
     {
         // Clear everything in the widget
         d->painter->fillRect(0, 0, width(), height(),
-                             d->prefs->backgroundColor());
+                             d->settings->backgroundColor());
     }
 
     d->painter->end();
     return Qx::Widget::paintEvent(e);
 }
 
-void View::extendBottom(int start, int end)
-{
-    Q_D(View);
-
-    int width = d->column * d->cellWidth;
-    int height = (end - start + 1) * d->cellHeight;
-    QPixmap m(width, height);
-    d->painter->begin(&m);
-    d->painter->drawPixmap(0, 0 - (start * d->cellHeight),
-                           width, height, *d->backImage);
-    d->painter->end();
-    d->painter->begin(d->backImage);
-    d->painter->drawPixmap(0, (start - 1) * d->cellHeight, width, height, m);
-    d->painter->fillRect(0, end * d->cellHeight, width, d->cellHeight,
-                       d->prefs->backgroundColor());
-    d->painter->end();
-}
-
-void View::extendTop(int start, int end)
-{
-    Q_D(View);
-
-    int width = d->column * d->cellWidth;
-    int height = (end - start + 1) * d->cellHeight;
-    QPixmap m(width, height);
-    d->painter->begin(&m);
-    d->painter->drawPixmap(0, 0 - (start * d->cellHeight),
-                           width, height, *d->backImage);
-    d->painter->end();
-    d->painter->begin(d->backImage);
-    d->painter->drawPixmap(0, (start + 1) * d->cellHeight, width, height, m);
-    d->painter->fillRect(0, start * d->cellHeight, width, d->cellHeight,
-                         d->prefs->backgroundColor());
-    d->painter->end();
-}
-
 void View::copy()
 {
     Q_D(View);
@@ -652,7 +672,8 @@ void View::copy()
     QMimeData *mime = new QMimeData();
 
     // Pure text
-    QString selection = d->terminal->stringFromIndex(start, length);
+    QString selection = d->screen->stringFromIndex(
+                start, length, d->terminal->encoding());
     mime->setText(selection);
 
     // Color copy
@@ -669,7 +690,7 @@ void View::copy()
     {
         int x = i % d->column;
         int y = i / d->column;
-        BBS::Cell &cell = d->terminal->cellsAtRow(y)[x];
+        const BBS::Cell &cell = d->screen->cellsAtRow(y)[x];
         if ((x == 0) && (i != start))   // newline
         {
             data.append('\r');
@@ -842,16 +863,17 @@ void View::setTerminal(Connection::Terminal *terminal)
     disconnect(d->terminal);
     delete d->terminal;
     d->terminal = terminal;
+    d->screen.clear();
+    d->clearBlinkingCells();
     if (!d->terminal)
         return;
+    d->takeScreen();
+    d->screen->setDirtyAll();
     d->terminal->setView(this);
-    connect(d->terminal, SIGNAL(dataProcessed()), SLOT(updateScreen()));
+    d->scheduler->connect(d->terminal, SIGNAL(dataProcessed()),
+                          SLOT(scheduleFrame()));
     d->terminal->connection()->connect(this, SIGNAL(hasBytesToSend(QByteArray)),
                                        SLOT(sendBytes(QByteArray)));
-    connect(d->terminal, SIGNAL(shouldExtendTop(int,int)),
-            SLOT(extendTop(int,int)));
-    connect(d->terminal, SIGNAL(shouldExtendBottom(int,int)),
-            SLOT(extendBottom(int,int)));
 }
 
 void View::setAddress(const QString &address)
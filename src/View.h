@@ -34,6 +34,7 @@ class Terminal;
 namespace Qelly
 {
 
+class FrameScheduler;
 class ViewPrivate;
 
 class View : public Qx::Widget
@@ -52,9 +53,6 @@ public slots:
     void updateBackImage();
     void updateBackground(int row, int startColumn, int endColumn);
     void updateText(int row);
-    void updateText(int row, int x);
-    void extendBottom(int start, int end);
-    void extendTop(int start, int end);
     void insertText(const QString &string, uint delayMs = 0);
     void copy();
     void paste();
@@ -71,7 +69,8 @@ protected:
     virtual void inputMethodEvent(QInputMethodEvent *e);
     virtual void paintEvent(QPaintEvent *e);
     virtual void focusInEvent(QFocusEvent *);
-    virtual void timerEvent(QTimerEvent *);
+    virtual void showEvent(QShowEvent *e);
+    virtual void hideEvent(QHideEvent *e);
     virtual bool focusNextPrevChild(bool);
 
 signals:
@@ -81,6 +80,8 @@ signals:
 private slots:
     void commitFromPreeditHolder(QInputMethodEvent *e);
     void clearPreeditHolder();
+    void flushDamage();
+    void blink(bool on);
     void popInsertBuffer();
     void openUrl();
     void google();
@@ -90,6 +91,7 @@ private:
 
 public: // Setters & Getters
     Connection::Terminal *terminal() const;
+    FrameScheduler *frameScheduler() const;
     void setTerminal(Connection::Terminal *terminal);
     void setAddress(const QString &address);
 };
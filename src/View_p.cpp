@@ -21,9 +21,17 @@
 #include <QMenu>
 #include <QPainter>
 #include <QRegExp>
+#include <QThread>
 #include <QTimer>
+#include <QVector>
+#include "BlinkClock.h"
+#include "BlockGlyphs.h"
 #include "Encodings.h"
+#include "FrameScheduler.h"
+#include "GlyphCache.h"
 #include "PreeditTextHolder.h"
+#include "RasterBackBuffer.h"
+#include "ScreenSnapshot.h"
 #include "SharedPreferences.h"
 #include "Site.h"
 #include "Terminal.h"
@@ -35,13 +43,74 @@ namespace UJ
 namespace Qelly
 {
 
+namespace
+{
+
+// Double-byte characters BBS pages use the most: the symbols and the
+// frequently used characters of Big5, and their GB2312 counterparts in GBK.
+struct CodeRange
+{
+    int leadBegin;
+    int leadEnd;
+    int trailBegin;
+    int trailEnd;
+};
+
+const CodeRange Big5CommonRanges[] = {
+    {0xa1, 0xa3, 0x40, 0xfe},   // Symbols
+    {0xa4, 0xc6, 0x40, 0xfe}    // Frequently used characters
+};
+
+const CodeRange GbkCommonRanges[] = {
+    {0xa1, 0xa9, 0xa1, 0xfe},   // Symbols
+    {0xb0, 0xd7, 0xa1, 0xfe}    // Level 1 hanzi
+};
+
+QVector<ushort> commonDoubleByteCodes(BBS::Encoding encoding)
+{
+    const unsigned short *table = YL::B2U;
+    const CodeRange *ranges = Big5CommonRanges;
+    if (encoding == BBS::EncodingGBK)
+    {
+        table = YL::G2U;
+        ranges = GbkCommonRanges;
+    }
+
+    QVector<ushort> codes;
+    for (int i = 0; i < 2; i++)
+    {
+        const CodeRange &r = ranges[i];
+        for (int lead = r.leadBegin; lead <= r.leadEnd; lead++)
+        {
+            for (int trail = r.trailBegin; trail <= r.trailEnd; trail++)
+            {
+                // Not a trail byte in either encoding
+                if (trail > 0x7e && trail < 0xa1)
+                    continue;
+                ushort code = table[(lead << 8) + trail - 0x8000];
+                if (code)
+                    codes << code;
+            }
+        }
+    }
+    return codes;
+}
+
+}   // namespace
+
 ViewPrivate::ViewPrivate(View *q)
     : q_ptr(q), selectedStart(PositionNotFound), selectedLength(0),
       markedStart(PositionNotFound), markedLength(0), backImage(0),
-      backImageFlipped(false), blinkTicker(false), terminal(0)
+      backRaster(0), backImageFlipped(false), blinkTicker(false), terminal(0),
+      repaintRequested(false)
 {
     prefs = SharedPreferences::sharedInstance();
+    glyphs = GlyphCache::sharedInstance();
+    blinkClock = BlinkClock::sharedInstance();
     painter = new QPainter();
+    scheduler = new FrameScheduler(q_ptr);
+    scheduler->setLatencyBudget(prefs->frameLatencyBudget());
+    q->connect(scheduler, SIGNAL(frameDue()), SLOT(updateScreen()));
     preeditHolder = new PreeditTextHolder(q_ptr);
     q->connect(preeditHolder, SIGNAL(hasCommitString(QInputMethodEvent*)),
                SLOT(commitFromPreeditHolder(QInputMethodEvent*)));
@@ -57,34 +126,85 @@ ViewPrivate::~ViewPrivate()
         delete painter;
     if (backImage)
         delete backImage;
+    if (backRaster)
+        delete backRaster;
 }
 
 void ViewPrivate::buildInfo()
 {
-    cellWidth = prefs->cellWidth();
-    cellHeight = prefs->cellHeight();
     row = BBS::SizeRowCount;
     column = BBS::SizeColumnCount;
+    clearBlinkingCells();
 
-    if (backImage)
-        delete backImage;
-    backImage = new QPixmap(cellWidth * column, cellHeight * row);
+    updateRenderSettings();
+    glyphs->warmUp(doubleGlyphStyle,
+                   commonDoubleByteCodes(prefs->defaultEncoding()));
 
-    if (singleAdvances.isEmpty() || doubleAdvances.isEmpty())
+    insertBuffer.clear();
+    insertTimer = new QTimer(q_ptr);
+    q_ptr->connect(insertTimer, SIGNAL(timeout()), SLOT(popInsertBuffer()));
+    // NOTE: Set _textField hidden...This is the MarkedTextView thingy
+}
+
+void ViewPrivate::takeScreen()
+{
+    // Nothing new if the terminal has not published since the last frame
+    QSharedPointer<Connection::ScreenSnapshot> next = terminal->takeSnapshot();
+    if (!next)
+        return;
+    if (screen)
+        next->mergeChangesFrom(*screen);
+    screen = next;
+}
+
+void ViewPrivate::syncRenderSettings()
+{
+    if (settings->version() != prefs->renderSettings()->version())
+        updateRenderSettings();
+}
+
+void ViewPrivate::updateRenderSettings()
+{
+    // Only called between frames, so that each frame is drawn with a single
+    // snapshot throughout
+    settings = prefs->renderSettings();
+    cellWidth = settings->cellWidth();
+    cellHeight = settings->cellHeight();
+    QSize size(cellWidth * column, cellHeight * row);
+    bool raster = settings->rasterBackBuffer();
+    QSize current;
+    if (backRaster)
+        current = backRaster->image().size();
+    else if (backImage)
+        current = backImage->size();
+    if (current != size || raster != (backRaster != 0))
     {
-        singleAdvances.clear();
-        doubleAdvances.clear();
-        for (int i = 0; i < column; i++)
+        delete backImage;
+        delete backRaster;
+        backImage = 0;
+        backRaster = 0;
+        if (raster)
         {
-            singleAdvances << QSize(cellWidth * 1, 0);
-            doubleAdvances << QSize(cellWidth * 2, 0);
+            // Two strips per core leave room to even out dense and sparse
+            // rows between the threads
+            int rows = qMax(1, row / (2 * QThread::idealThreadCount()));
+            backRaster = new RasterBackBuffer(size, rows * cellHeight);
         }
+        else
+        {
+            backImage = new QPixmap(size);
+        }
+        q_ptr->setFixedSize(size);
     }
+    damage.setGrid(row, column, cellWidth, cellHeight);
+    updateGlyphStyles();
 
-    insertBuffer.clear();
-    insertTimer = new QTimer(q_ptr);
-    q_ptr->connect(insertTimer, SIGNAL(timeout()), SLOT(popInsertBuffer()));
-    // NOTE: Set _textField hidden...This is the MarkedTextView thingy
+    // Everything on the back image was drawn with the old settings
+    if (screen)
+    {
+        screen->clearRowMoves();
+        screen->setDirtyAll();
+    }
 }
 
 int ViewPrivate::indexFromPoint(const QPoint &point)
@@ -123,22 +243,22 @@ void ViewPrivate::moveCursorTo(int destRow, int destCol)
 {
     QByteArray cmd;
     bool needsVertical = false;
-    if (destRow > terminal->cursorRow())
+    if (destRow > screen->cursorRow())
     {
         needsVertical = true;
         cmd.append('\x01');
-        for (int i = terminal->cursorRow(); i < destRow; i++)
+        for (int i = screen->cursorRow(); i < destRow; i++)
             cmd.append("\x1b\x4f\x42");
     }
-    else if (destRow < terminal->cursorRow())
+    else if (destRow < screen->cursorRow())
     {
         needsVertical = true;
         cmd.append('\x01');
-        for (int i = terminal->cursorRow(); i > destRow; i--)
+        for (int i = screen->cursorRow(); i > destRow; i--)
             cmd.append("\x1b\x4f\x41");
     }
 
-    BBS::Cell *row = terminal->cellsAtRow(destRow);
+    const BBS::Cell *row = screen->cellsAtRow(destRow);
     bool siteDblByte = terminal->connection()->site()->manualDoubleByte();
     if (needsVertical)
     {
@@ -148,17 +268,17 @@ void ViewPrivate::moveCursorTo(int destRow, int destCol)
                 cmd.append("\x1b\x4f\x43");
         }
     }
-    else if (destCol > terminal->cursorColumn())
+    else if (destCol > screen->cursorColumn())
     {
-        for (int i = terminal->cursorColumn(); i < destCol; i++)
+        for (int i = screen->cursorColumn(); i < destCol; i++)
         {
             if (row[i].attr.f.doubleByte != 2 || siteDblByte)
                 cmd.append("\x1b\x4f\x43");
         }
     }
-    else if (destCol < terminal->cursorColumn())
+    else if (destCol < screen->cursorColumn())
     {
-        for (int i = terminal->cursorColumn(); i > destCol; i--)
+        for (int i = screen->cursorColumn(); i > destCol; i--)
         {
             if (row[i].attr.f.doubleByte != 2 || siteDblByte)
                 cmd.append("\x1b\x4f\x44");
@@ -170,7 +290,7 @@ void ViewPrivate::moveCursorTo(int destRow, int destCol)
 
 void ViewPrivate::selectWordAround(int r, int c)
 {
-    BBS::Cell *cell = terminal->cellsAtRow(r);
+    const BBS::Cell *cell = screen->cellsAtRow(r);
     while (c >= 0)
     {
         if (isAlphanumeric(cell[c].byte) && !cell[c].attr.f.doubleByte)
@@ -355,15 +475,14 @@ void ViewPrivate::handleArrowKey(int key)
     default:
         return;
     }
-    int row = terminal->cursorRow();
-    int column = terminal->cursorColumn();
-    terminal->updateDoubleByteStateForRow(row);
+    int row = screen->cursorRow();
+    int column = screen->cursorColumn();
     if (terminal->connection()->site()->manualDoubleByte())
     {
         if ((key == Qt::Key_Right &&
-             terminal->attributeOfCellAt(row, column).f.doubleByte == 1) ||
+             screen->doubleByteStateAt(row, column) == 1) ||
             (key == Qt::Key_Left &&
-             terminal->attributeOfCellAt(row, column - 1).f.doubleByte == 2))
+             screen->doubleByteStateAt(row, column - 1) == 2))
         {
             arrow.append(arrow);
         }
@@ -400,10 +519,9 @@ void ViewPrivate::handleForwardDeleteKey()
     QByteArray bytes("\x1b[3~");
     if (terminal->connection()->site()->manualDoubleByte())
     {
-        int x = terminal->cursorColumn();
-        int y = terminal->cursorRow();
-        if (x < column - 1 &&
-            terminal->attributeOfCellAt(y, x + 1).f.doubleByte == 2)
+        int x = screen->cursorColumn();
+        int y = screen->cursorRow();
+        if (screen->doubleByteStateAt(y, x + 1) == 2)
         {
             bytes.append(bytes);
         }
@@ -415,181 +533,54 @@ void ViewPrivate::handleForwardDeleteKey()
 void ViewPrivate::handleAsciiDelete()
 {
     QByteArray buffer("\x08");
-    int row = terminal->cursorRow();
-    int column = terminal->cursorColumn();
+    int row = screen->cursorRow();
+    int column = screen->cursorColumn();
     if (terminal->connection()->site()->manualDoubleByte() &&
-        terminal->attributeOfCellAt(row, column - 1).f.doubleByte == 2 &&
-        column > 0)
+        screen->doubleByteStateAt(row, column - 1) == 2)
     {
         buffer.append(buffer);
     }
     emit q_ptr->hasBytesToSend(buffer);
 }
 
-void ViewPrivate::drawSpecialSymbol(
-        ushort code, int row, int column,
-        BBS::CellAttribute left, BBS::CellAttribute right)
+void ViewPrivate::drawBlockTile(ushort code, int row, int column, int width,
+                                QRgb left, QRgb right)
 {
-    //  0   1   2
-    //
-    //  3   4   5
-    //
-    //  6   7   8
-    //
-    int w = cellWidth;
-    int h = cellHeight;
-    int xs[9] = {column * w, (column + 1) * w, (column + 2) * w,
-                 column * w, (column + 1) * w, (column + 2) * w,
-                 column * w, (column + 1) * w, (column + 2) * w};
-    int ys[9] = {row * h, row * h, row * h,
-                 row * h + h/2, row * h + h/2, row * h + h/2,
-                 (row + 1) * h, (row + 1) * h, (row + 1) * h};
-    painter->begin(backImage);
-    painter->setPen(Qt::NoPen);
-    QPoint points[4];
-    switch (code)
-    {
-    case 0x2581:    // ▁ Lower one eighth block
-    case 0x2582:    // ▂ Lower one quarter block
-    case 0x2583:    // ▃ Lower three eighths block
-    case 0x2584:    // ▄ Lower half block
-    case 0x2585:    // ▅ Lower five eighths block
-    case 0x2586:    // ▆ Lower three quarters block
-    case 0x2587:    // ▇ Lower seven eights block
-    case 0x2588:    // █ Full block
-        painter->fillRect(
-                xs[0], ys[6] - h * (code - 0x2580) / 8, w,
-                h * (code - 0x2580) / 8,
-                prefs->fColor(left.f.fColorIndex, left.f.bright));
-        painter->fillRect(
-                xs[1], ys[7] - h * (code - 0x2580) / 8, w,
-                h * (code - 0x2580) / 8,
-                prefs->fColor(right.f.fColorIndex, right.f.bright));
-        break;
-    case 0x2589:    // ▉ Left seven eights block
-    case 0x258a:    // ▊ Left three quarters block
-    case 0x258b:    // ▋ Left five eighths block
-        painter->fillRect(
-                xs[0], ys[0], w, h,
-                prefs->fColor(left.f.fColorIndex, left.f.bright));
-        painter->fillRect(
-                xs[1], ys[1], w * (0x258c - code) / 8, h,
-                prefs->fColor(right.f.fColorIndex, right.f.bright));
-        break;
-    case 0x258c:    // ▌ Left half block
-    case 0x258d:    // ▍ Left three eighths block
-    case 0x258e:    // ▎ Left one quarter block
-    case 0x258f:    // ▏ Left one eighth block
-        painter->fillRect(
-                xs[0], ys[0], w * (0x2590 - code) / 8, h,
-                prefs->fColor(left.f.fColorIndex, left.f.bright));
-        break;
-    case 0x25e2:    // ◢ Black lower right triangle
-        //painter->setPen(Qt::SolidLine);
-        painter->setBrush(QBrush(prefs->fColor(left.f.fColorIndex,
-                                               left.f.bright),
-                                 Qt::SolidPattern));
-        points[0] = QPoint(xs[4], ys[4]);
-        points[1] = QPoint(xs[7], ys[7]);
-        points[2] = QPoint(xs[6], ys[6]);
-        painter->drawPolygon(points, 3);
-        painter->setBrush(QBrush(prefs->fColor(right.f.fColorIndex,
-                                                     right.f.bright),
-                                    Qt::SolidPattern));
-        points[2] = QPoint(xs[8], ys[8]);
-        points[3] = QPoint(xs[2], ys[2]);
-        painter->drawPolygon(points, 4);
-        break;
-    case 0x25e3:    // ◣ Black lower left triangle
-        painter->setBrush(QBrush(prefs->fColor(left.f.fColorIndex,
-                                                     left.f.bright),
-                                    Qt::SolidPattern));
-        points[0] = QPoint(xs[4], ys[4]);
-        points[1] = QPoint(xs[7], ys[7]);
-        points[2] = QPoint(xs[6], ys[6]);
-        points[3] = QPoint(xs[0], ys[0]);
-        painter->drawPolygon(points, 4);
-        painter->setBrush(QBrush(prefs->fColor(right.f.fColorIndex,
-                                                     right.f.bright),
-                                    Qt::SolidPattern));
-        points[2] = QPoint(xs[8], ys[8]);
-        painter->drawPolygon(points, 3);
-        break;
-    case 0x25e4:    // ◤ Black upper left triangle
-        painter->setBrush(QBrush(prefs->fColor(left.f.fColorIndex,
-                                                     left.f.bright),
-                                    Qt::SolidPattern));
-        points[0] = QPoint(xs[4], ys[4]);
-        points[1] = QPoint(xs[1], ys[1]);
-        points[2] = QPoint(xs[0], ys[0]);
-        points[3] = QPoint(xs[6], ys[6]);
-        painter->drawPolygon(points, 4);
-        painter->setBrush(QBrush(prefs->fColor(right.f.fColorIndex,
-                                                 right.f.bright),
-                                Qt::SolidPattern));
-        points[2] = QPoint(xs[2], ys[2]);
-        painter->drawPolygon(points, 3);
-        break;
-    case 0x25e5:    // ◥ Black upper right triangle
-        painter->setBrush(QBrush(prefs->fColor(left.f.fColorIndex,
-                                                 left.f.bright),
-                                Qt::SolidPattern));
-        points[0] = QPoint(xs[4], ys[4]);
-        points[1] = QPoint(xs[1], ys[1]);
-        points[2] = QPoint(xs[0], ys[0]);
-        painter->drawPolygon(points, 3);
-        painter->setBrush(QBrush(prefs->fColor(right.f.fColorIndex,
-                                                 right.f.bright),
-                                Qt::SolidPattern));
-        points[2] = QPoint(xs[2], ys[2]);
-        points[3] = QPoint(xs[8], ys[8]);
-        painter->drawPolygon(points, 4);
-        break;
-    case 0x25fc:    // ◼ Black medium square    // paint as a full block
-        painter->fillRect(xs[0], ys[0], w, h,
-                           prefs->fColor(left.f.fColorIndex, left.f.bright));
-        painter->fillRect(xs[1], ys[1], w, h,
-                           prefs->fColor(right.f.fColorIndex, right.f.bright));
-        break;
-    default:
-        break;
-    }
-    painter->end();
+    QPoint point(column * cellWidth, row * cellHeight);
+    QSize size(cellWidth * width, cellHeight);
+    if (backRaster)
+        backRaster->blit(point, glyphs->tileImage(code, size, left, right));
+    else
+        painter->drawPixmap(point, glyphs->tile(code, size, left, right));
 }
 
 void ViewPrivate::drawDoubleColor(
         ushort code, int row, int column,
         BBS::CellAttribute left, BBS::CellAttribute right)
 {
-    int dblPadLeft = prefs->doubleByteFontPaddingLeft();
-    int dblPadBottom = prefs->doubleByteFontPaddingBottom();
-    QFont dblFont = prefs->doubleByteFont();
-
-    // Left side
-    QPixmap lp(cellWidth, cellHeight);
-    lp.fill(prefs->bColor(left.f.bColorIndex));
-    painter->begin(&lp);
-    painter->setFont(dblFont);
-    painter->setPen(prefs->fColor(left.f.fColorIndex, left.f.bright));
-    painter->drawText(dblPadLeft, cellHeight - dblPadBottom, QChar(code));
-    painter->end();
-
-    // Right side
-    QPixmap rp(cellWidth, cellHeight);
-    rp.fill(prefs->bColor(right.f.bColorIndex));
-    painter->begin(&rp);
-    painter->setFont(dblFont);
-    painter->setPen(prefs->fColor(right.f.fColorIndex, right.f.bright));
-    painter->drawText(dblPadLeft - cellWidth, cellHeight - dblPadBottom,
-                       QChar(code));
-    painter->end();
-
-    // Draw the left half of left side, right half of the right side
-    painter->begin(backImage);
-    painter->setBackgroundMode(Qt::TransparentMode);
-    painter->drawPixmap(column * cellWidth, row * cellHeight, lp);
-    painter->drawPixmap((column + 1) * cellWidth, row * cellHeight, rp);
-    painter->end();
+    // The glyph in each color comes from the cache; draw the left half of
+    // one and the right half of the other over the background already there
+    QRgb leftColor = settings->fColor(left.f.fColorIndex, left.f.bright);
+    QRgb rightColor = settings->fColor(right.f.fColorIndex, right.f.bright);
+    int x = column * cellWidth;
+    int y = row * cellHeight;
+    QRect leftHalf(0, 0, cellWidth, cellHeight);
+    QRect rightHalf(cellWidth, 0, cellWidth, cellHeight);
+    if (backRaster)
+    {
+        backRaster->blit(QPoint(x, y), glyphs->glyphImage(
+                             doubleGlyphStyle, code, leftColor), leftHalf);
+        backRaster->blit(QPoint(x + cellWidth, y), glyphs->glyphImage(
+                             doubleGlyphStyle, code, rightColor), rightHalf);
+    }
+    else
+    {
+        painter->drawPixmap(QPoint(x, y), glyphs->glyph(
+                                doubleGlyphStyle, code, leftColor), leftHalf);
+        painter->drawPixmap(QPoint(x + cellWidth, y), glyphs->glyph(
+                                doubleGlyphStyle, code, rightColor),
+                            rightHalf);
+    }
 }
 
 void ViewPrivate::paintSelection()
@@ -642,22 +633,88 @@ void ViewPrivate::paintBlink(QRect &r)
 
     for (int y = r.top() / cellHeight; y <= r.bottom() / cellHeight; y++)
     {
-        BBS::Cell *cells = terminal->cellsAtRow(y);
+        if (y >= row || blinkBegins[y] >= blinkEnds[y])
+            continue;
+        const BBS::Cell *cells = screen->cellsAtRow(y);
         for (int x = r.left() / cellWidth; x < r.right() / cellWidth + 1; x++)
         {
-            BBS::CellAttribute &a = cells[x].attr;
+            const BBS::CellAttribute &a = cells[x].attr;
             if (!a.f.blinking)
                 continue;
             int colorIndex = a.f.reversed ? a.f.fColorIndex : a.f.bColorIndex;
             bool bright = a.f.reversed ? a.f.bright : false;
             painter->setPen(Qt::NoPen);
-            painter->setBrush(QBrush(prefs->bColor(colorIndex, bright)));
+            painter->setBrush(settings->bBrush(colorIndex, bright));
             painter->drawRect(x * cellWidth, y * cellHeight,
                               cellWidth, cellHeight);
         }
     }
 }
 
+void ViewPrivate::moveBackImageRows()
+{
+    // Each block of rows that moved together is scrolled in place. Blocks
+    // that moved up go first, top to bottom, then those that moved down,
+    // bottom to top; that way a block never overwrites rows another block
+    // still has to read, except when a block moved down from rows an upward
+    // one has already covered. Such a block is simply painted again.
+    QVector<bool> overwritten(row, false);
+    for (int y = 0; y < row; )
+    {
+        int origin = screen->rowOriginAt(y);
+        int n = 1;
+        while (origin > y && y + n < row &&
+               screen->rowOriginAt(y + n) == origin + n)
+            n++;
+        if (origin > y)
+        {
+            scrollBackImage(origin, y, n);
+            for (int i = y; i < y + n; i++)
+                overwritten[i] = true;
+        }
+        y += n;
+    }
+    for (int y = row - 1; y >= 0; )
+    {
+        int origin = screen->rowOriginAt(y);
+        int n = 1;
+        while (origin >= 0 && origin < y && origin - n >= 0 &&
+               screen->rowOriginAt(y - n) == origin - n)
+            n++;
+        if (origin >= 0 && origin < y)
+        {
+            bool readable = true;
+            for (int i = origin - n + 1; i <= origin; i++)
+                readable = readable && !overwritten[i];
+            if (readable)
+            {
+                scrollBackImage(origin - n + 1, y - n + 1, n);
+            }
+            else
+            {
+                for (int i = y - n + 1; i <= y; i++)
+                    screen->setDirtyRow(i);
+            }
+        }
+        y -= n;
+    }
+    screen->clearRowMoves();
+}
+
+void ViewPrivate::scrollBackImage(int from, int to, int count)
+{
+    int width = column * cellWidth;
+    int top = from * cellHeight;
+    int height = count * cellHeight;
+    int offset = int(to * cellHeight) - top;
+    if (backRaster)
+        backRaster->scroll(top, height, offset);
+    else
+        backImage->scroll(0, offset, 0, top, width, height);
+    moveBlinkingCells(from, to, count);
+    damage.addRows(to, count);
+}
+
 void ViewPrivate::refreshHiddenRegion()
 {
 
@@ -665,57 +722,61 @@ void ViewPrivate::refreshHiddenRegion()
 
 void ViewPrivate::clearSelection()
 {
-    Q_Q(View);
-
     if (selectedLength)
     {
         int start = selectedLength > 0 ?
                     selectedStart : selectedStart + selectedLength - 1;
         int length = selectedLength > 0 ?
                     selectedLength : 0 - (selectedLength - 1);
-        int startY = start / column;
-        int endY = (start + length) / column;
-        if (startY == endY)
-        {
-            q->update(start % column * cellWidth, startY * cellHeight,
-                      length * cellWidth, cellHeight);
-        }
-        else
+        damageIndices(start, length);
+        requestRepaint();
+        selectedLength = 0;
+    }
+}
+
+void ViewPrivate::updateText(int row, int begin, int end)
+{
+    // Cells are drawn in runs sharing a foreground color, so the color is
+    // looked up once per run rather than once per cell
+    const BBS::Cell *cells = screen->cellsAtRow(row);
+    BBS::Encoding encoding = terminal->connection()->site()->encoding();
+    int x = begin;
+    while (x < end)
+    {
+        BBS::CellAttribute attr = cells[x].attr;
+        int runEnd = x + 1;
+        while (runEnd < end
+               && cells[runEnd].attr.f.fColorIndex == attr.f.fColorIndex
+               && cells[runEnd].attr.f.bright == attr.f.bright)
         {
-            q->update(0, startY * cellHeight, column * cellWidth,
-                      (endY - startY + 1) * cellHeight);
+            runEnd++;
         }
-        selectedLength = 0;
+        QRgb color = settings->fColor(attr.f.fColorIndex, attr.f.bright);
+        for (; x < runEnd; x++)
+            updateText(row, x, cells, encoding, color);
     }
 }
 
-void ViewPrivate::updateText(int row, int column)
+void ViewPrivate::updateText(int row, int column,
+                             const BBS::Cell *cells, BBS::Encoding encoding,
+                             QRgb color)
 {
-    int sglPadLeft = prefs->defaultFontPaddingLeft();
-    int sglPadBott = prefs->defaultFontPaddingBottom();
-    int dblPadLeft = prefs->doubleByteFontPaddingLeft();
-    int dblPadBott = prefs->doubleByteFontPaddingBottom();
-    QFont sglFont = prefs->defaultFont();
-    QFont dblFont = prefs->doubleByteFont();
-    BBS::Cell *cells = terminal->cellsAtRow(row);
-    BBS::CellAttribute &attr = cells[column].attr;
     ushort code;
-    switch (attr.f.doubleByte)
+    switch (cells[column].attr.f.doubleByte)
     {
     case 0: // Not double byte
-        painter->begin(backImage);
-        painter->setFont(sglFont);
-        painter->setPen(prefs->fColor(attr.f.fColorIndex, attr.f.bright));
-        code = cells[column].byte ? cells[column].byte : ' ';
-        painter->drawText(column * cellWidth + sglPadLeft,
-                             (row + 1) * cellHeight - sglPadBott,
-                             QChar(code));
-        painter->end();
+        code = cells[column].byte;
+        if (cells[column].attr.f.isGraphic)
+            code = decSpecialGraphic(code);
+        if (isBlockGlyph(code))
+            drawBlockTile(code, row, column, 1, color, color);
+        else if (code && code != ' ' && code != 0xa0)   // Nothing to draw
+            drawGlyph(singleGlyphStyle, code, row, column, color);
         break;
     case 1: // First half of double byte
         break;
     case 2:
-        switch (terminal->connection()->site()->encoding())
+        switch (encoding)
         {
         case BBS::EncodingBig5:
             code = YL::B2U[(static_cast<ushort>(cells[column - 1].byte) << 8) +
@@ -730,10 +791,12 @@ void ViewPrivate::updateText(int row, int column)
                     (static_cast<ushort>(cells[column].byte) - 0x8000));
             break;
         }
-        if (isSpecialSymbol(code))
+        if (isBlockGlyph(code))
         {
-            drawSpecialSymbol(code, row, column - 1,
-                                 cells[column - 1].attr, cells[column].attr);
+            BBS::CellAttribute left = cells[column - 1].attr;
+            drawBlockTile(code, row, column - 1, 2,
+                          settings->fColor(left.f.fColorIndex, left.f.bright),
+                          color);
         }
         else
         {
@@ -746,14 +809,7 @@ void ViewPrivate::updateText(int row, int column)
             }
             else
             {
-                painter->begin(backImage);
-                painter->setFont(dblFont);
-                painter->setPen(prefs->fColor(attr.f.fColorIndex,
-                                                    attr.f.bright));
-                painter->drawText((column - 1) * cellWidth + dblPadLeft,
-                                     (row + 1) * cellHeight - dblPadBott,
-                                     QChar(code));
-                painter->end();
+                drawGlyph(doubleGlyphStyle, code, row, column - 1, color);
             }
         }
     }
@@ -761,7 +817,115 @@ void ViewPrivate::updateText(int row, int column)
 
 void ViewPrivate::displayCellAt(int column, int row)
 {
-    q_ptr->update(column * cellWidth, row * cellHeight, cellWidth, cellHeight);
+    damage.addCells(row, column, column + 1);
+}
+
+void ViewPrivate::damageIndices(int start, int length)
+{
+    int end = start + length;
+    for (int y = start / column; y * column < end; y++)
+        damage.addCells(y, start - y * column, end - y * column);
+}
+
+void ViewPrivate::indexBlinkingCells(int row)
+{
+    const BBS::Cell *cells = screen->cellsAtRow(row);
+    int begin = column;
+    int end = 0;
+    for (int x = 0; x < column; x++)
+    {
+        if (cells[x].attr.f.blinking)
+        {
+            if (begin > x)
+                begin = x;
+            end = x + 1;
+        }
+    }
+    bool blinked = blinkBegins[row] < blinkEnds[row];
+    bool blinks = begin < end;
+    blinkingRows += int(blinks) - int(blinked);
+    blinkBegins[row] = begin;
+    blinkEnds[row] = end;
+}
+
+void ViewPrivate::moveBlinkingCells(int from, int to, int count)
+{
+    // Follows the rows scrolled on the back image
+    QVector<int> begins = blinkBegins.mid(from, count);
+    QVector<int> ends = blinkEnds.mid(from, count);
+    for (int i = 0; i < count; i++)
+    {
+        blinkBegins[to + i] = begins[i];
+        blinkEnds[to + i] = ends[i];
+    }
+    blinkingRows = 0;
+    for (int y = 0; y < row; y++)
+    {
+        if (blinkBegins[y] < blinkEnds[y])
+            blinkingRows++;
+    }
+}
+
+void ViewPrivate::clearBlinkingCells()
+{
+    blinkBegins.fill(column, row);
+    blinkEnds.fill(0, row);
+    blinkingRows = 0;
+}
+
+void ViewPrivate::updateBlinkSubscription()
+{
+    if (q_ptr->isVisible() && blinkingRows)
+    {
+        blinkTicker = blinkClock->isOn();
+        blinkClock->subscribe(q_ptr, SLOT(blink(bool)));
+    }
+    else
+    {
+        blinkClock->unsubscribe(q_ptr);
+        blinkTicker = false;
+    }
+}
+
+void ViewPrivate::requestRepaint()
+{
+    // Damage from outside a frame (selection, blinking) is collected until
+    // the event loop comes around, and repainted together
+    if (repaintRequested)
+        return;
+    repaintRequested = true;
+    QMetaObject::invokeMethod(q_ptr, "flushDamage", Qt::QueuedConnection);
+}
+
+void ViewPrivate::flushDamage()
+{
+    repaintRequested = false;
+    if (!damage.isEmpty())
+        q_ptr->update(damage.takeRegion());
+}
+
+void ViewPrivate::updateGlyphStyles()
+{
+    int width = cellWidth;
+    int height = cellHeight;
+    singleGlyphStyle = glyphs->style(
+                settings->defaultFont(), QSize(width, height),
+                QPoint(settings->defaultFontPaddingLeft(),
+                       height - settings->defaultFontPaddingBottom()));
+    doubleGlyphStyle = glyphs->style(
+                settings->doubleByteFont(), QSize(width * 2, height),
+                QPoint(settings->doubleByteFontPaddingLeft(),
+                       height - settings->doubleByteFontPaddingBottom()));
+}
+
+void ViewPrivate::drawGlyph(int style, ushort code, int row, int column,
+                            QRgb color)
+{
+    QPoint point(column * cellWidth, row * cellHeight);
+    if (backRaster)
+        backRaster->blit(point, glyphs->glyphImage(style, code, color));
+    else
+        painter->drawPixmap(point, glyphs->glyph(style, code, color));
 }
 
 QString ViewPrivate::selection() const
@@ -775,7 +939,7 @@ QString ViewPrivate::selection() const
         start += length;
         length = 0 - length;
     }
-    return terminal->stringFromIndex(start, length);
+    return screen->stringFromIndex(start, length, terminal->encoding());
 }
 
 void ViewPrivate::showPreeditHolder()
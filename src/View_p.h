@@ -24,8 +24,10 @@
 #include <QPoint>
 #include <QQueue>
 #include <QRect>
+#include <QSharedPointer>
 #include <QTextStream>
 #include <QVector>
+#include "DamageRegion.h"
 #include "Globals.h"
 class QMenu;
 class QPainter;
@@ -36,6 +38,7 @@ namespace UJ
 
 namespace Connection
 {
+class ScreenSnapshot;
 class Terminal;
 }
 
@@ -43,7 +46,12 @@ namespace Qelly
 {
 
 class View;
+class BlinkClock;
+class FrameScheduler;
+class GlyphCache;
 class PreeditTextHolder;
+class RasterBackBuffer;
+class RenderSettings;
 class SharedPreferences;
 
 class ViewPrivate
@@ -58,6 +66,9 @@ public:
     ~ViewPrivate();
 
     void buildInfo();
+    void takeScreen();
+    void syncRenderSettings();
+    void updateRenderSettings();
 
     int indexFromPoint(const QPoint &point);
     QPoint pointFromIndex(int x, int y);
@@ -72,22 +83,34 @@ public:
     void handleAsciiDelete();       // 0x7f
 
     void displayCellAt(int column, int row);
-    void drawSpecialSymbol(ushort code, int row, int column,
-                           BBS::CellAttribute left, BBS::CellAttribute right);
+    void damageIndices(int start, int length);
+    void indexBlinkingCells(int row);
+    void moveBlinkingCells(int from, int to, int count);
+    void clearBlinkingCells();
+    void updateBlinkSubscription();
+    void requestRepaint();
+    void flushDamage();
+    void updateGlyphStyles();
+    void drawGlyph(int style, ushort code, int row, int column, QRgb color);
+    void drawBlockTile(ushort code, int row, int column, int width,
+                       QRgb left, QRgb right);
     void drawDoubleColor(ushort code, int row, int column,
                          BBS::CellAttribute left, BBS::CellAttribute right);
+    void moveBackImageRows();
+    void scrollBackImage(int from, int to, int count);
     void paintSelection();
     void paintBlink(QRect &r);
     void refreshHiddenRegion();
     void clearSelection();
-    void updateText(int row, int column);
-
-    inline int fColorIndex(BBS::CellAttribute &attribute) const;
-    inline int bColorIndex(BBS::CellAttribute &attribute) const;
-    inline int fBright(BBS::CellAttribute &attribute) const;
-    inline int bBright(BBS::CellAttribute &attribute) const;
+    void updateText(int row, int begin, int end);
+    void updateText(int row, int column, const BBS::Cell *cells,
+                    BBS::Encoding encoding, QRgb color);
+
+    inline int fColorIndex(const BBS::CellAttribute &attribute) const;
+    inline int bColorIndex(const BBS::CellAttribute &attribute) const;
+    inline int fBright(const BBS::CellAttribute &attribute) const;
+    inline int bBright(const BBS::CellAttribute &attribute) const;
     inline bool isAlphanumeric(uchar c) const;
-    inline bool isSpecialSymbol(ushort code) const;
 
     inline QString shortUrlFromString(const QString &source) const;
     inline QString longUrlFromString(const QString &source) const;
@@ -102,6 +125,7 @@ public:
     void hidePreeditHolder();
 
     SharedPreferences *prefs;
+    QSharedPointer<const RenderSettings> settings;
     double cellWidth;
     double cellHeight;
     int row;
@@ -115,17 +139,27 @@ public:
     int markedStart;
     int markedLength;
     QPixmap *backImage;
+    RasterBackBuffer *backRaster;   // Instead of backImage if set
     bool backImageFlipped;
     bool blinkTicker;
-    QVector<QSize> singleAdvances;
-    QVector<QSize> doubleAdvances;
+    BlinkClock *blinkClock;
+    QVector<int> blinkBegins;       // Span of blinking cells in each row
+    QVector<int> blinkEnds;
+    int blinkingRows;
     Connection::Terminal *terminal;
+    QSharedPointer<Connection::ScreenSnapshot> screen;  // What is drawn
     QPainter *painter;
+    FrameScheduler *scheduler;
+    DamageRegion damage;
+    bool repaintRequested;
+    GlyphCache *glyphs;
+    int singleGlyphStyle;
+    int doubleGlyphStyle;
     QString address;
     PreeditTextHolder *preeditHolder;
 };
 
-int ViewPrivate::fColorIndex(BBS::CellAttribute &attribute) const
+int ViewPrivate::fColorIndex(const BBS::CellAttribute &attribute) const
 {
     if (attribute.f.reversed)
         return attribute.f.bColorIndex;
@@ -133,7 +167,7 @@ int ViewPrivate::fColorIndex(BBS::CellAttribute &attribute) const
         return attribute.f.fColorIndex;
 }
 
-int ViewPrivate::bColorIndex(BBS::CellAttribute &attribute) const
+int ViewPrivate::bColorIndex(const BBS::CellAttribute &attribute) const
 {
     if (attribute.f.reversed)
         return attribute.f.fColorIndex;
@@ -141,12 +175,12 @@ int ViewPrivate::bColorIndex(BBS::CellAttribute &attribute) const
         return attribute.f.bColorIndex;
 }
 
-int ViewPrivate::fBright(BBS::CellAttribute &attribute) const
+int ViewPrivate::fBright(const BBS::CellAttribute &attribute) const
 {
     return !attribute.f.reversed && attribute.f.bright;
 }
 
-int ViewPrivate::bBright(BBS::CellAttribute &attribute) const
+int ViewPrivate::bBright(const BBS::CellAttribute &attribute) const
 {
     return attribute.f.reversed && attribute.f.bright;
 }
@@ -156,37 +190,6 @@ bool ViewPrivate::isAlphanumeric(uchar c) const
     return (std::isalnum(c) || (c == '-') || (c == '_') || (c == '.'));
 }
 
-bool ViewPrivate::isSpecialSymbol(ushort code) const
-{
-    switch (code)
-    {
-    case 0x2581:    // ▁ Lower one eighth block
-    case 0x2582:    // ▂ Lower one quarter block
-    case 0x2583:    // ▃ Lower three eighths block
-    case 0x2584:    // ▄ Lower half block
-    case 0x2585:    // ▅ Lower five eighths block
-    case 0x2586:    // ▆ Lower three quarters block
-    case 0x2587:    // ▇ Lower seven eights block
-    case 0x2588:    // █ Full block
-    case 0x2589:    // ▉ Left seven eights block
-    case 0x258a:    // ▊ Left three quarters block
-    case 0x258b:    // ▋ Left five eighths block
-    case 0x258c:    // ▌ Left half block
-    case 0x258d:    // ▍ Left three eighths block
-    case 0x258e:    // ▎ Left one quarter block
-    case 0x258f:    // ▏ Left one eighth block
-    case 0x25e2:    // ◢ Black lower right triangle
-    case 0x25e3:    // ◣ Black lower left triangle
-    case 0x25e4:    // ◤ Black upper left triangle
-    case 0x25e5:    // ◥ Black upper right triangle
-    case 0x25fc:    // ◼ Black medium square
-        return true;
-    default:
-        return false;
-    }
-    return false;
-}
-
 QString ViewPrivate::shortUrlFromString(const QString &source) const
 {
     QString result;
@@ -50,16 +50,28 @@ SOURCES += main.cpp \
     MainWindow.cpp \
     SharedMenuBar.cpp \
     Terminal.cpp \
+    ScreenSnapshot.cpp \
     Encodings.cpp \
     AbstractConnection.cpp \
+    IoChannel.cpp \
     Site.cpp \
     Ssh.cpp \
     Telnet.cpp \
+    Replay.cpp \
+    SessionRecording.cpp \
     TabWidget.cpp \
     View.cpp \
+    FrameScheduler.cpp \
+    DamageRegion.cpp \
+    BlinkClock.cpp \
+    RasterBackBuffer.cpp \
+    GlyphCache.cpp \
+    BlockGlyphs.cpp \
     UJQxWidget.cpp \
+    UJByteScan.cpp \
     Controller.cpp \
     SharedPreferences.cpp \
+    RenderSettings.cpp \
     PreferencesGeneral.cpp \
     PreferencesWindow.cpp \
     PreferencesFont.cpp \
@@ -74,18 +86,33 @@ HEADERS  += \
     Globals.h \
     YLTerminal.h \
     Terminal.h \
+    ScreenSnapshot.h \
+    CsiParameters.h \
     Encodings.h \
     UJCommonDefs.h \
+    DataSink.h \
     AbstractConnection.h \
+    IoChannel.h \
     Site.h \
     Ssh.h \
     Telnet.h \
     YLTelnet.h \
+    Replay.h \
+    SessionRecording.h \
     TabWidget.h \
     View.h \
+    FrameScheduler.h \
+    DamageRegion.h \
+    BlinkClock.h \
+    RasterBackBuffer.h \
+    GlyphCache.h \
+    BlockGlyphs.h \
     UJQxWidget.h \
+    UJByteScan.h \
+    UJSpscQueue.h \
     Controller.h \
     SharedPreferences.h \
+    RenderSettings.h \
     PreferencesGeneral.h \
     PreferencesWindow.h \
     PreferencesFont.h \
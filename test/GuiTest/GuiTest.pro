@@ -17,7 +17,9 @@ SOURCES += main.cpp \
     ../../src/View.cpp \
     ../../src/UJQxWidget.cpp \
     ../../src/Encodings.cpp \
-    ../../src/Terminal.cpp
+    ../../src/Terminal.cpp \
+    ../../src/ScreenSnapshot.cpp \
+    ../../src/UJByteScan.cpp
 
 HEADERS  += \
     ../../src/SharedMenuBar.h \
@@ -28,7 +30,9 @@ HEADERS  += \
     ../Test/UJQxTestUtilities.h \
     ../../src/UJQxWidget.h \
     ../../src/Encodings.h \
-    ../../src/Terminal.h
+    ../../src/Terminal.h \
+    ../../src/ScreenSnapshot.h \
+    ../../src/UJByteScan.h
 
 
 
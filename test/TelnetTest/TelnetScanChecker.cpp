@@ -0,0 +1,362 @@
+/*****************************************************************************
+ * TelnetScanChecker.cpp
+ *
+ * Created: 17/10 2026 by uranusjr
+ *
+ * Copyright 2026 uranusjr. All rights reserved.
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ *****************************************************************************/
+
+#include "TelnetScanChecker.h"
+#include "YLTelnet.h"
+
+namespace
+{
+
+// A tiny LCG so the random streams are the same on every platform
+class Generator
+{
+public:
+    explicit Generator(uint seed) : _state(seed) {}
+    int next(int bound)
+    {
+        _state = _state * 1103515245u + 12345u;
+        return (_state >> 16) % bound;
+    }
+
+private:
+    uint _state;
+};
+
+inline char byte(int c)
+{
+    return static_cast<char>(c);
+}
+
+// Telnet's decoder before the bulk scan, one byte at a time
+class ReferenceDecoder
+{
+public:
+    explicit ReferenceDecoder(bool synced) :
+        _state(TopLevel), _synced(synced), _sbOption(0)
+    {
+    }
+
+    void decode(const QByteArray &bytes)
+    {
+        for (int i = 0; i < bytes.size(); i++)
+            decode(static_cast<uchar>(bytes.at(i)));
+    }
+
+    QByteArray data;
+    QByteArray replies;
+
+private:
+    enum State
+    {
+        TopLevel, SeenIac, SeenWill, SeenWont, SeenDo, SeenDont, SeenSb,
+        SubNegotiation, SubNegotiationIac, SeenCr
+    };
+
+    void decode(uchar c)
+    {
+        switch (_state)
+        {
+        case SeenCr:
+            if (c == NUL)
+            {
+                _state = TopLevel;
+                break;
+            }
+            // Fall through
+        case TopLevel:
+            if (c == IAC)
+            {
+                _state = SeenIac;
+                break;
+            }
+            if (!_synced)
+                data.append(byte(c));
+            else if (c == DM)
+                _synced = false;
+            _state = c == CR ? SeenCr : TopLevel;
+            break;
+        case SeenIac:
+            switch (c)
+            {
+            case DO:
+                _state = SeenDo;
+                break;
+            case DONT:
+                _state = SeenDont;
+                break;
+            case WILL:
+                _state = SeenWill;
+                break;
+            case WONT:
+                _state = SeenWont;
+                break;
+            case SB:
+                _state = SeenSb;
+                break;
+            case DM:
+                _synced = false;
+                _state = TopLevel;
+                break;
+            default:
+                _state = TopLevel;
+                break;
+            }
+            break;
+        case SeenWill:
+            if (c == TELOPT_ECHO || c == TELOPT_SGA || c == TELOPT_BINARY)
+                command(DO, c);
+            else
+                command(DONT, c);
+            _state = TopLevel;
+            break;
+        case SeenWont:
+            command(DONT, c);
+            _state = TopLevel;
+            break;
+        case SeenDo:
+            if (c == TELOPT_NAWS)
+            {
+                command(WILL, c);
+                replies.append(byte(IAC)).append(byte(SB));
+                replies.append(byte(TELOPT_NAWS));
+                replies.append(QByteArray("\x00\x50\x00\x18", 4));
+                replies.append(byte(IAC)).append(byte(SE));
+            }
+            else if (c == TELOPT_TTYPE || c == TELOPT_BINARY)
+            {
+                command(WILL, c);
+            }
+            else
+            {
+                command(WONT, c);
+            }
+            _state = TopLevel;
+            break;
+        case SeenDont:
+            command(WONT, c);
+            _state = TopLevel;
+            break;
+        case SeenSb:
+            _sbOption = c;
+            _sbBuffer.clear();
+            _state = SubNegotiation;
+            break;
+        case SubNegotiation:
+            if (c == IAC)
+                _state = SubNegotiationIac;
+            else
+                _sbBuffer.append(byte(c));
+            break;
+        case SubNegotiationIac:
+            if (c == SE)
+            {
+                if (_sbOption == TELOPT_TTYPE && _sbBuffer.size() == 1 &&
+                        _sbBuffer.at(0) == TELQUAL_SEND)
+                {
+                    replies.append(byte(IAC)).append(byte(SB));
+                    replies.append(byte(TELOPT_TTYPE));
+                    replies.append(byte(TELQUAL_IS)).append("vt100");
+                    replies.append(byte(IAC)).append(byte(SE));
+                }
+                _sbBuffer.clear();
+                _state = TopLevel;
+            }
+            else
+            {
+                _sbBuffer.append(byte(c));
+                _state = SubNegotiation;
+            }
+            break;
+        }
+    }
+
+    void command(uchar cmd, uchar option)
+    {
+        replies.append(byte(IAC)).append(byte(cmd)).append(byte(option));
+    }
+
+    State _state;
+    bool _synced;
+    uchar _sbOption;
+    QByteArray _sbBuffer;
+};
+
+QByteArray sequence(const char *data, int size)
+{
+    return QByteArray(data, size);
+}
+
+}   // namespace
+
+TelnetScanChecker::TelnetScanChecker(QObject *parent) : Tester(parent)
+{
+}
+
+int TelnetScanChecker::run()
+{
+    // Byte values spelled out: IAC 0xff, DM 0xf2, SB 0xfa, SE 0xf0,
+    // WILL 0xfb, WONT 0xfc, DO 0xfd, DONT 0xfe
+    bool ok = true;
+    ok &= checkSplits("plain data",
+                      sequence("Hello, world\x1b[m", 15));
+    ok &= checkSplits("IAC IAC",
+                      sequence("ab\xff\xff" "cd", 6));
+    ok &= checkSplits("CR NUL",
+                      sequence("a\r\0b\r\0\r\0", 8));
+    ok &= checkSplits("CR CR NUL",
+                      sequence("a\r\r\0b", 5));
+    ok &= checkSplits("CR LF",
+                      sequence("a\r\nb\r", 5));
+    ok &= checkSplits("CR IAC",
+                      sequence("a\r\xff\xfd\x01" "b\r\xff\xff", 9));
+    ok &= checkSplits("DM while synced",
+                      sequence("xyz\xf2" "abc\xff\xf2" "de", 11), true);
+    ok &= checkSplits("IAC DM while synced",
+                      sequence("xyz\xff\xf2" "abc", 8), true);
+    ok &= checkSplits("DM while not synced",
+                      sequence("a\xf2" "b", 3));
+    ok &= checkSplits("WILL and WONT",
+                      sequence("a\xff\xfb\x01\xff\xfb\x63"
+                               "\xff\xfc\x05" "b", 11));
+    ok &= checkSplits("DO and DONT",
+                      sequence("\xff\xfd\x1f\xff\xfd\x18\xff\xfd\x07"
+                               "\xff\xfe\x00" "c", 13));
+    ok &= checkSplits("terminal type",
+                      sequence("a\xff\xfa\x18\x01\xff\xf0" "b", 8));
+    ok &= checkSplits("subnegotiation with IAC",
+                      sequence("\xff\xfa\x18\x01\xff\x01\x02\xff\xf0"
+                               "z", 10));
+    ok &= checkCleanChunkIsShared();
+    ok &= checkRandomStreams(20000);
+
+    *_cout << (ok ? "All checks passed\n" : "Some checks FAILED\n");
+    _cout->flush();
+    return ok ? 0 : 1;
+}
+
+void TelnetScanChecker::collectData(QByteArray bytes)
+{
+    _data.append(bytes);
+    _lastData = bytes;
+}
+
+void TelnetScanChecker::collectReply(QByteArray bytes)
+{
+    _replies.append(bytes);
+}
+
+bool TelnetScanChecker::check(const char *name,
+                              const QList<QByteArray> &chunks, bool synced)
+{
+    UJ::Connection::Telnet telnet;
+    telnet._synced = synced;
+    connect(&telnet, SIGNAL(processedBytes(QByteArray)),
+            this, SLOT(collectData(QByteArray)));
+    connect(&telnet, SIGNAL(hasBytesToSend(QByteArray)),
+            this, SLOT(collectReply(QByteArray)));
+    _data.clear();
+    _replies.clear();
+
+    ReferenceDecoder reference(synced);
+    for (int i = 0; i < chunks.size(); i++)
+    {
+        telnet.processBytes(chunks.at(i));
+        reference.decode(chunks.at(i));
+    }
+    if (_data == reference.data && _replies == reference.replies)
+        return true;
+
+    *_cout << "FAIL " << name << ": data " << _data.toHex()
+           << " expected " << reference.data.toHex() << ", replies "
+           << _replies.toHex() << " expected "
+           << reference.replies.toHex() << "\n";
+    _cout->flush();
+    return false;
+}
+
+bool TelnetScanChecker::checkSplits(const char *name,
+                                    const QByteArray &stream, bool synced)
+{
+    // Whole, cut in two at every point, and one byte at a time, so that
+    // every sequence is also seen split across chunks
+    QList<QByteArray> chunks;
+    chunks.append(stream);
+    if (!check(name, chunks, synced))
+        return false;
+    for (int cut = 1; cut < stream.size(); cut++)
+    {
+        chunks.clear();
+        chunks.append(stream.left(cut));
+        chunks.append(stream.mid(cut));
+        if (!check(name, chunks, synced))
+            return false;
+    }
+    chunks.clear();
+    for (int i = 0; i < stream.size(); i++)
+        chunks.append(stream.mid(i, 1));
+    return check(name, chunks, synced);
+}
+
+bool TelnetScanChecker::checkCleanChunkIsShared()
+{
+    // Nothing to take out, so the chunk should be passed on without a copy
+    UJ::Connection::Telnet telnet;
+    connect(&telnet, SIGNAL(processedBytes(QByteArray)),
+            this, SLOT(collectData(QByteArray)));
+    QByteArray chunk("plain text with\r\nline breaks");
+    _lastData.clear();
+    telnet.processBytes(chunk);
+    if (_lastData.constData() == chunk.constData())
+        return true;
+    *_cout << "FAIL clean chunk was copied\n";
+    _cout->flush();
+    return false;
+}
+
+bool TelnetScanChecker::checkRandomStreams(int count)
+{
+    // Mostly data, with enough commands, CRs and NULs in between to hit
+    // every state, in chunks of random size
+    static const uchar specials[] = {
+        IAC, IAC, CR, NUL, DM, SB, SE, WILL, WONT, DO, DONT,
+        TELOPT_TTYPE, TELOPT_NAWS, TELQUAL_SEND
+    };
+    Generator g(1);
+    for (int n = 0; n < count; n++)
+    {
+        bool synced = g.next(8) == 0;
+        QList<QByteArray> chunks;
+        int chunkCount = 1 + g.next(6);
+        for (int i = 0; i < chunkCount; i++)
+        {
+            QByteArray chunk;
+            int size = g.next(600);
+            for (int j = 0; j < size; j++)
+            {
+                if (g.next(5) == 0)
+                    chunk.append(byte(specials[g.next(sizeof(specials))]));
+                else
+                    chunk.append(byte(g.next(256)));
+            }
+            chunks.append(chunk);
+        }
+        if (!check("random stream", chunks, synced))
+            return false;
+    }
+    return true;
+}
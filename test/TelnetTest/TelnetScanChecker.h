@@ -0,0 +1,58 @@
+/*****************************************************************************
+ * TelnetScanChecker.h
+ *
+ * Created: 17/10 2026 by uranusjr
+ *
+ * Copyright 2026 uranusjr. All rights reserved.
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ *****************************************************************************/
+
+#ifndef TELNETSCANCHECKER_H
+#define TELNETSCANCHECKER_H
+
+#include <QByteArray>
+#include <QList>
+#include "../Test/UJQxTestUtilities.h"
+#include "Telnet.h"
+
+// Feeds byte streams to Telnet::processBytes() and to a reference decoder
+// that walks every byte through the option state machine, the way Telnet
+// did before it scanned data runs in bulk, and checks that both pass on the
+// same data and send the same replies however the stream is split. It is a
+// friend of Telnet so it can put it in synch mode, which the protocol code
+// never enters on its own.
+class TelnetScanChecker : public UJ::Qx::Tester
+{
+    Q_OBJECT
+
+public:
+    explicit TelnetScanChecker(QObject *parent = 0);
+    int run();
+
+private slots:
+    void collectData(QByteArray bytes);
+    void collectReply(QByteArray bytes);
+
+private:
+    bool check(const char *name, const QList<QByteArray> &chunks,
+               bool synced);
+    bool checkSplits(const char *name, const QByteArray &stream,
+                     bool synced = false);
+    bool checkCleanChunkIsShared();
+    bool checkRandomStreams(int count);
+
+    QByteArray _data;
+    QByteArray _replies;
+    QByteArray _lastData;
+};
+
+#endif // TELNETSCANCHECKER_H
@@ -14,16 +14,27 @@ CONFIG   -= app_bundle
 
 TEMPLATE = app
 
-INCLUDEPATH += ../../src
+INCLUDEPATH += ../Test ../../src
 
 SOURCES += main.cpp \
     TelnetTester.cpp \
+    TelnetScanChecker.cpp \
     ../../src/Telnet.cpp \
-    ../../src/AbstractConnection.cpp
+    ../../src/Site.cpp \
+    ../../src/AbstractConnection.cpp \
+    ../../src/IoChannel.cpp \
+    ../../src/UJByteScan.cpp
 
 HEADERS += \
     TelnetTester.h \
+    TelnetScanChecker.h \
     ../../src/Telnet.h \
+    ../../src/YLTelnet.h \
+    ../../src/Site.h \
     ../../src/AbstractConnection.h \
+    ../../src/DataSink.h \
+    ../../src/IoChannel.h \
+    ../../src/UJByteScan.h \
+    ../../src/UJSpscQueue.h \
     ../Test/UJQxTestUtilities.h
 
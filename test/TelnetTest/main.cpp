@@ -1,9 +1,19 @@
 #include <QtCore/QCoreApplication>
+#include <QtCore/QStringList>
+#include "TelnetScanChecker.h"
 #include "TelnetTester.h"
 
 int main(int argc, char *argv[])
 {
     QCoreApplication a(argc, argv);
+
+    // Offline; compares the data path against the byte-at-a-time decoder
+    if (a.arguments().contains("--check-scanner"))
+    {
+        TelnetScanChecker checker;
+        return checker.run();
+    }
+
     TelnetTester t;
 
     return a.exec();
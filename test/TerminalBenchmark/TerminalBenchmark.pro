@@ -0,0 +1,53 @@
+#-------------------------------------------------
+#
+# Offline parser benchmark. Feeds recorded or generated byte streams into
+# Terminal without a socket and reports throughput and per-handler timing.
+# With --check, checks instead that the screen comes out the same however
+# the streams are split.
+#
+#-------------------------------------------------
+
+QT       += core gui widgets network
+
+TARGET = TerminalBenchmark
+CONFIG   += console precompile_header
+CONFIG   -= app_bundle
+
+TEMPLATE = app
+
+DEFINES += QELLY_PARSER_PROFILING
+
+INCLUDEPATH += ../Test ../../src
+
+PRECOMPILED_HEADER = ../../src/UJCommonDefs.h
+
+SOURCES += main.cpp \
+    ../../src/Terminal.cpp \
+    ../../src/ScreenSnapshot.cpp \
+    ../../src/Site.cpp \
+    ../../src/AbstractConnection.cpp \
+    ../../src/IoChannel.cpp \
+    ../../src/Encodings.cpp \
+    ../../src/SessionRecording.cpp \
+    ../../src/UJByteScan.cpp \
+    TerminalBenchmarker.cpp \
+    TerminalChecker.cpp
+
+HEADERS += \
+    ../../src/Terminal.h \
+    ../../src/ScreenSnapshot.h \
+    ../../src/CsiParameters.h \
+    ../../src/YLTerminal.h \
+    ../../src/UJCommonDefs.h \
+    ../../src/Globals.h \
+    ../../src/ParserProfiler.h \
+    ../../src/Site.h \
+    ../../src/AbstractConnection.h \
+    ../../src/DataSink.h \
+    ../../src/IoChannel.h \
+    ../../src/SessionRecording.h \
+    ../../src/UJByteScan.h \
+    ../../src/UJSpscQueue.h \
+    TerminalBenchmarker.h \
+    TerminalChecker.h \
+    ../Test/UJQxTestUtilities.h
@@ -0,0 +1,479 @@
+/*****************************************************************************
+ * TerminalBenchmarker.cpp
+ *
+ * Created: 16/10 2026 by uranusjr
+ *
+ * Copyright 2026 uranusjr. All rights reserved.
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ *****************************************************************************/
+
+#include "TerminalBenchmarker.h"
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include "Globals.h"
+#include "ParserProfiler.h"
+#include "SessionRecording.h"
+#include "Site.h"
+#include "TerminalChecker.h"
+
+using UJ::Connection::ParserProfiler;
+using UJ::Connection::SessionRecording;
+
+namespace
+{
+
+// A tiny LCG so the generated corpora are byte-identical on every platform
+class Generator
+{
+public:
+    explicit Generator(uint seed) : _state(seed) {}
+    int next(int bound)
+    {
+        _state = _state * 1103515245u + 12345u;
+        return (_state >> 16) % bound;
+    }
+
+private:
+    uint _state;
+};
+
+void appendBig5(QByteArray &bytes, Generator &g)
+{
+    bytes.append(static_cast<char>(0xa4 + g.next(0x23)));
+    bytes.append(static_cast<char>(0x40 + g.next(0x3f)));
+}
+
+void appendAscii(QByteArray &bytes, Generator &g, int length)
+{
+    for (int i = 0; i < length; i++)
+        bytes.append(static_cast<char>(' ' + g.next(95)));
+}
+
+void appendSgr(QByteArray &bytes, int bright, int fg, int bg)
+{
+    bytes.append("\x1b[");
+    bytes.append(QByteArray::number(bright));
+    bytes.append(';');
+    bytes.append(QByteArray::number(30 + fg));
+    bytes.append(';');
+    bytes.append(QByteArray::number(40 + bg));
+    bytes.append('m');
+}
+
+void appendCup(QByteArray &bytes, int row, int column)
+{
+    bytes.append("\x1b[");
+    bytes.append(QByteArray::number(row));
+    bytes.append(';');
+    bytes.append(QByteArray::number(column));
+    bytes.append('H');
+}
+
+// Reading an article: full page redraws followed by line-by-line scrolling,
+// each line repainting the status bar, as PTT does for the down arrow key.
+QByteArray articlePaging()
+{
+    Generator g(1);
+    QByteArray bytes;
+    for (int page = 0; page < 40; page++)
+    {
+        bytes.append("\x1b[H\x1b[J");
+        bytes.append("\x1b[34;47m \xa7\x40\xaa\xcc \x1b[44;37m ");
+        appendAscii(bytes, g, 30);
+        bytes.append("\x1b[K\x1b[m\r\n");
+        for (int y = 1; y < 23; y++)
+        {
+            int words = g.next(30);
+            for (int w = 0; w < words; w++)
+                appendBig5(bytes, g);
+            appendAscii(bytes, g, g.next(16));
+            bytes.append("\r\n");
+        }
+        bytes.append("\x1b[24;1H\x1b[34;46m \xc2\x73\xc4\xfd \x1b[31;47m ");
+        appendAscii(bytes, g, 40);
+        bytes.append("\x1b[K\x1b[m");
+    }
+    for (int line = 0; line < 400; line++)
+    {
+        bytes.append("\x1b[24;1H\x1b[K\r\n\x1b[23;1H");
+        int words = g.next(35);
+        for (int w = 0; w < words; w++)
+            appendBig5(bytes, g);
+        bytes.append("\x1b[24;1H\x1b[34;46m \xc2\x73\xc4\xfd \x1b[31;47m ");
+        appendAscii(bytes, g, 40);
+        bytes.append("\x1b[K\x1b[m");
+    }
+    return bytes;
+}
+
+// Colored ANSI art: double-byte block elements with frequent SGR changes,
+// often with the two halves of one character in different colors.
+QByteArray coloredArt()
+{
+    Generator g(2);
+    QByteArray bytes;
+    for (int screen = 0; screen < 60; screen++)
+    {
+        bytes.append("\x1b[H\x1b[J");
+        for (int y = 0; y < 23; y++)
+        {
+            for (int x = 0; x < 80; x += 2)
+            {
+                if (g.next(3))
+                    appendSgr(bytes, g.next(2), g.next(8), g.next(8));
+                bytes.append('\xa2');
+                bytes.append(static_cast<char>(0x62 + g.next(15)));
+            }
+            bytes.append("\x1b[m\r\n");
+        }
+    }
+    return bytes;
+}
+
+// Board lists: absolutely positioned rows, a highlighted cursor bar moving
+// up and down, and partial row rewrites.
+QByteArray boardList()
+{
+    Generator g(3);
+    QByteArray bytes;
+    for (int screen = 0; screen < 60; screen++)
+    {
+        bytes.append("\x1b[H\x1b[J\x1b[1;44;37m\xac\xdd\xaa\x4f ");
+        appendAscii(bytes, g, 70);
+        bytes.append("\x1b[m");
+        for (int y = 3; y < 23; y++)
+        {
+            appendCup(bytes, y + 1, 1);
+            bytes.append("   ");
+            bytes.append(QByteArray::number(screen * 20 + y));
+            bytes.append(g.next(4) ? " + " : " m ");
+            bytes.append("\x1b[1;32m");
+            appendAscii(bytes, g, 5);
+            bytes.append("\x1b[m ");
+            appendAscii(bytes, g, 12);
+            bytes.append(" \xa1\xbc ");
+            int words = g.next(20);
+            for (int w = 0; w < words; w++)
+                appendBig5(bytes, g);
+        }
+        for (int move = 0; move < 20; move++)
+        {
+            int y = 4 + g.next(20);
+            appendCup(bytes, y, 1);
+            bytes.append("\x1b[1;37;44m>");
+            appendAscii(bytes, g, 40);
+            bytes.append("\x1b[m\x1b[K");
+        }
+    }
+    return bytes;
+}
+
+// Editor-like traffic dominated by cursor addressing, erasing, line
+// insertion and deletion inside scroll regions.
+QByteArray cursorMovement()
+{
+    Generator g(4);
+    QByteArray bytes;
+    for (int op = 0; op < 20000; op++)
+    {
+        switch (g.next(9))
+        {
+        case 0:
+            appendCup(bytes, 1 + g.next(24), 1 + g.next(80));
+            break;
+        case 1:
+            bytes.append("\x1b[K");
+            break;
+        case 2:     // IL/DL inside a scroll region, with the cursor in it
+            bytes.append("\x1b[3;22r");
+            appendCup(bytes, 3 + g.next(20), 1);
+            bytes.append("\x1b[");
+            bytes.append(QByteArray::number(1 + g.next(3)));
+            bytes.append(g.next(2) ? 'L' : 'M');
+            bytes.append("\x1b[r");
+            break;
+        case 3:
+            bytes.append("\x1b[");
+            bytes.append(QByteArray::number(1 + g.next(4)));
+            bytes.append('P');
+            break;
+        case 4:
+            bytes.append("\x1b[");
+            bytes.append(QByteArray::number(1 + g.next(5)));
+            bytes.append("ABCD"[g.next(4)]);
+            break;
+        case 5:
+            appendCup(bytes, 24, 1);
+            bytes.append("\x1b" "D");
+            break;
+        case 6:
+            appendCup(bytes, 1, 1);
+            bytes.append("\x1b" "M");
+            break;
+        default:
+            appendAscii(bytes, g, 1 + g.next(8));
+            break;
+        }
+    }
+    return bytes;
+}
+
+}   // namespace
+
+NullConnection::NullConnection(QObject *parent) : AbstractConnection(parent)
+{
+    UJ::Connection::Site *site = new UJ::Connection::Site("benchmark");
+    site->setEncoding(UJ::BBS::EncodingBig5);
+    setSite(site);
+    setConnected(true);
+}
+
+bool NullConnection::connectTo(const QString &, qint16)
+{
+    return true;
+}
+
+void NullConnection::close()
+{
+}
+
+void NullConnection::reconnect()
+{
+}
+
+void NullConnection::sendBytes(QByteArray)
+{
+}
+
+void NullConnection::processBytes(QByteArray bytes)
+{
+    emit processedBytes(bytes);
+}
+
+TerminalBenchmarker::TerminalBenchmarker(QObject *parent) : Tester(parent)
+{
+    _chunkSize = 256;   // What Telnet hands the terminal
+    _rounds = 5;
+}
+
+int TerminalBenchmarker::run(const QStringList &arguments)
+{
+    bool check = false;
+    for (int i = 0; i < arguments.size(); i++)
+    {
+        const QString &arg = arguments.at(i);
+        if (arg == "--check")
+        {
+            check = true;
+        }
+        else if (arg == "-c" && i + 1 < arguments.size())
+        {
+            _chunkSize = qMax(1, arguments.at(++i).toInt());
+        }
+        else if (arg == "-r" && i + 1 < arguments.size())
+        {
+            _rounds = qMax(1, arguments.at(++i).toInt());
+        }
+        else if (arg.startsWith('-'))
+        {
+            *_cout << "Usage: TerminalBenchmark [--check] [-c chunk-size] "
+                      "[-r rounds] [capture...]\n";
+            _cout->flush();
+            return 1;
+        }
+        else if (!addCorpusFile(arg))
+        {
+            *_cout << "Cannot read capture " << arg << "\n";
+            _cout->flush();
+            return 1;
+        }
+    }
+    if (_corpora.isEmpty())
+        addBuiltinCorpora();
+
+    // Whether the parser draws the same however the data is split, instead
+    // of how fast it goes
+    if (check)
+    {
+        TerminalChecker checker;
+        return checker.run(_corpora);
+    }
+
+    *_cout << "Chunk size " << _chunkSize << ", best of " << _rounds
+           << " rounds\n";
+    foreach (const Corpus &corpus, _corpora)
+        benchmark(corpus);
+    benchmarkScreenOperations();
+    _cout->flush();
+    return 0;
+}
+
+void TerminalBenchmarker::addBuiltinCorpora()
+{
+    Corpus corpus;
+    corpus.name = "article paging";
+    corpus.data = articlePaging();
+    _corpora << corpus;
+    corpus.name = "colored ANSI art";
+    corpus.data = coloredArt();
+    _corpora << corpus;
+    corpus.name = "board list";
+    corpus.data = boardList();
+    _corpora << corpus;
+    corpus.name = "CSI cursor movement";
+    corpus.data = cursorMovement();
+    _corpora << corpus;
+}
+
+bool TerminalBenchmarker::addCorpusFile(const QString &path)
+{
+    // A capture is either a session recording, or the raw byte stream as
+    // Terminal receives it, i.e. after Telnet negotiation has been stripped.
+    Corpus corpus;
+    corpus.name = QFileInfo(path).fileName();
+    SessionRecording recording(path);
+    if (recording.isValid())
+    {
+        for (int i = 0; i < recording.count(); i++)
+        {
+            SessionRecording::Record r = recording.record(i);
+            if (r.direction == SessionRecording::DirectionInbound)
+                corpus.data.append(r.bytes);
+        }
+    }
+    else
+    {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly))
+            return false;
+        corpus.data = file.readAll();
+    }
+    _corpora << corpus;
+    return true;
+}
+
+QList<QByteArray> TerminalBenchmarker::split(const QByteArray &data) const
+{
+    QList<QByteArray> chunks;
+    for (int i = 0; i < data.size(); i += _chunkSize)
+        chunks << data.mid(i, _chunkSize);
+    return chunks;
+}
+
+qint64 TerminalBenchmarker::feed(const QList<QByteArray> &chunks) const
+{
+    // Start from a fresh screen every time so each round does the same work
+    UJ::Connection::Terminal terminal;
+    terminal.setConnection(new NullConnection(&terminal));
+
+    QElapsedTimer timer;
+    timer.start();
+    foreach (const QByteArray &chunk, chunks)
+        terminal.processIncomingData(chunk);
+    return timer.nsecsElapsed();
+}
+
+void TerminalBenchmarker::benchmark(const Corpus &corpus)
+{
+    QList<QByteArray> chunks = split(corpus.data);
+    qint64 bytes = corpus.data.size();
+
+    qint64 best = -1;
+    for (int i = 0; i < _rounds; i++)
+    {
+        qint64 nsecs = feed(chunks);
+        if (best < 0 || nsecs < best)
+            best = nsecs;
+    }
+
+    // A separate, instrumented round for the per-handler split. Timing every
+    // handler call is far from free, so it does not count toward throughput.
+    ParserProfiler::reset();
+    ParserProfiler::setEnabled(true);
+    feed(chunks);
+    ParserProfiler::setEnabled(false);
+
+    qint64 total = 0;
+    for (int i = 0; i < ParserProfiler::HandlerCount; i++)
+        total += ParserProfiler::nsecs()[i];
+    double cells = ParserProfiler::cells();
+    double screens = cells / (UJ::BBS::SizeRowCount * UJ::BBS::SizeColumnCount);
+
+    *_cout << "\n== " << corpus.name << " ==\n";
+    *_cout << "  " << bytes << " bytes in " << chunks.size() << " chunks, "
+           << QString::number(best / 1000000.0, 'f', 2) << " ms, "
+           << QString::number(bytes * 1000.0 / qMax(best, qint64(1)), 'f', 2)
+           << " MB/s\n";
+    *_cout << "  " << QString::number(screens, 'f', 1) << " screens written, "
+           << (screens > 0 ? QString::number(bytes / screens, 'f', 1)
+                           : QString("-"))
+           << " bytes/screen\n";
+    *_cout << QString("  %1 %2 %3 %4\n")
+              .arg("handler", -38).arg("calls", 10).arg("ms", 9).arg("%", 6);
+    for (int i = 0; i < ParserProfiler::HandlerCount; i++)
+    {
+        qint64 calls = ParserProfiler::calls()[i];
+        if (!calls)
+            continue;
+        qint64 nsecs = ParserProfiler::nsecs()[i];
+        *_cout << QString("  %1 %2 %3 %4\n")
+                  .arg(ParserProfiler::name(i), -38)
+                  .arg(calls, 10)
+                  .arg(nsecs / 1000000.0, 9, 'f', 2)
+                  .arg(100.0 * nsecs / qMax(total, qint64(1)), 6, 'f', 1);
+    }
+}
+
+void TerminalBenchmarker::benchmarkScreenOperations()
+{
+    // Whole-screen work that goes straight to the cell buffer, with as little
+    // parsing around it as possible: three or four bytes per operation.
+    *_cout << "\n== screen buffer ==\n";
+    *_cout << QString("  %1 %2 %3\n")
+              .arg("operation", -38).arg("count", 10).arg("ns/op", 9);
+    benchmarkScreenOperation("clear (ED 2)", "", "\x1b[2J", 20000);
+    benchmarkScreenOperation("scroll up (LF at bottom)",
+                             "\x1b[24;1H", "\n", 50000);
+    benchmarkScreenOperation("scroll down (RI at top)",
+                             "\x1b[1;1H", "\x1bM", 50000);
+    benchmarkScreenOperation("scroll region (LF at margin)",
+                             "\x1b[3;22r\x1b[22;1H", "\n", 50000);
+    benchmarkScreenOperation("insert line (IL)", "\x1b[5;1H", "\x1b[L", 50000);
+    benchmarkScreenOperation("delete line (DL)", "\x1b[5;1H", "\x1b[M", 50000);
+    benchmarkScreenOperation("fill (DECALN)", "", "\x1b#8", 20000);
+}
+
+void TerminalBenchmarker::benchmarkScreenOperation(
+        const char *name, const QByteArray &setup, const QByteArray &operation,
+        int count)
+{
+    QByteArray data = operation.repeated(count);
+    qint64 best = -1;
+    for (int i = 0; i < _rounds; i++)
+    {
+        UJ::Connection::Terminal terminal;
+        terminal.setConnection(new NullConnection(&terminal));
+        terminal.processIncomingData(setup);
+
+        QElapsedTimer timer;
+        timer.start();
+        terminal.processIncomingData(data);
+        qint64 nsecs = timer.nsecsElapsed();
+        if (best < 0 || nsecs < best)
+            best = nsecs;
+    }
+    *_cout << QString("  %1 %2 %3\n")
+              .arg(name, -38)
+              .arg(count, 10)
+              .arg(double(best) / count, 9, 'f', 1);
+}
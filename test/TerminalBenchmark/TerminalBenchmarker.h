@@ -0,0 +1,74 @@
+/*****************************************************************************
+ * TerminalBenchmarker.h
+ *
+ * Created: 16/10 2026 by uranusjr
+ *
+ * Copyright 2026 uranusjr. All rights reserved.
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ *****************************************************************************/
+
+#ifndef TERMINALBENCHMARKER_H
+#define TERMINALBENCHMARKER_H
+
+#include <UJQxTestUtilities.h>
+#include <QList>
+#include <QStringList>
+#include "AbstractConnection.h"
+#include "Terminal.h"
+
+// A connection that goes nowhere. Terminal needs one to answer DA/DSR and to
+// look up the site encoding, but nothing it sends matters here.
+class NullConnection : public UJ::Connection::AbstractConnection
+{
+public:
+    explicit NullConnection(QObject *parent = 0);
+    virtual bool connectTo(const QString &address, qint16 port);
+
+public slots:
+    virtual void close();
+    virtual void reconnect();
+    virtual void sendBytes(QByteArray bytes);
+
+protected slots:
+    virtual void processBytes(QByteArray bytes);
+};
+
+class TerminalBenchmarker : public UJ::Qx::Tester
+{
+    Q_OBJECT
+
+public:
+    struct Corpus
+    {
+        QString name;
+        QByteArray data;
+    };
+
+    explicit TerminalBenchmarker(QObject *parent = 0);
+    int run(const QStringList &arguments);
+
+private:
+    void addBuiltinCorpora();
+    bool addCorpusFile(const QString &path);
+    QList<QByteArray> split(const QByteArray &data) const;
+    qint64 feed(const QList<QByteArray> &chunks) const;
+    void benchmark(const Corpus &corpus);
+    void benchmarkScreenOperations();
+    void benchmarkScreenOperation(const char *name, const QByteArray &setup,
+                                  const QByteArray &operation, int count);
+
+    QList<Corpus> _corpora;
+    int _chunkSize;
+    int _rounds;
+};
+
+#endif // TERMINALBENCHMARKER_H
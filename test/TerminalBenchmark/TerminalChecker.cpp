@@ -0,0 +1,247 @@
+/*****************************************************************************
+ * TerminalChecker.cpp
+ *
+ * Created: 17/10 2026 by uranusjr
+ *
+ * Copyright 2026 uranusjr. All rights reserved.
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ *****************************************************************************/
+
+#include "TerminalChecker.h"
+#include "Terminal.h"
+
+using UJ::Connection::Terminal;
+using UJ::Connection::UrlSpan;
+
+namespace
+{
+
+// Cutting a whole corpus in two at every point would parse it once per byte,
+// so only this much of its start is; the rest is cut everywhere by the small
+// chunk sizes instead
+const int CutPrefixSize = 4096;
+
+QList<QByteArray> chunked(const QByteArray &data, int size)
+{
+    QList<QByteArray> chunks;
+    for (int i = 0; i < data.size(); i += size)
+        chunks << data.mid(i, size);
+    return chunks;
+}
+
+// Every row numbered, so that it shows where rows were scrolled to
+QByteArray numberedRows()
+{
+    QByteArray bytes("\x1b[H\x1b[J");
+    for (int y = 1; y <= UJ::BBS::SizeRowCount; y++)
+    {
+        bytes.append("row ");
+        bytes.append(QByteArray::number(y));
+        if (y < UJ::BBS::SizeRowCount)
+            bytes.append("\r\n");
+    }
+    return bytes;
+}
+
+}   // namespace
+
+TerminalChecker::TerminalChecker(QObject *parent) : Tester(parent)
+{
+}
+
+int TerminalChecker::run(const QList<TerminalBenchmarker::Corpus> &corpora)
+{
+    QByteArray rows = numberedRows();
+    QByteArray scroll("\x1b[24;1H\n\nA");
+    bool ok = true;
+
+    // Both spellings of an indexed color, and direct colors, whose
+    // components must not be taken for attributes
+    ok &= checkSame("SGR 38:5:n",
+                    "\x1b[38:5:1;48:5:4mAB\x1b[38:5:200mC\x1b[mD",
+                    "\x1b[31;44mABC\x1b[mD");
+    ok &= checkSame("SGR 38;5;n",
+                    "\x1b[38;5;1;48;5;4mAB\x1b[38;5;200mC\x1b[mD",
+                    "\x1b[31;44mABC\x1b[mD");
+    ok &= checkSame("SGR 38:2", "\x1b[38:2::1:4:5;1mX", "\x1b[1mX");
+    ok &= checkSame("SGR 38;2", "\x1b[38;2;1;4;5;1mX", "\x1b[1mX");
+
+    // Zero and omitted margins both mean the edge of the screen
+    ok &= checkSame("DECSTBM 0;0", rows + "\x1b[0;0r" + scroll,
+                    rows + "\x1b[1;24r" + scroll);
+    ok &= checkSame("DECSTBM omitted", rows + "\x1b[r" + scroll,
+                    rows + "\x1b[1;24r" + scroll);
+    ok &= checkSame("DECSTBM 5;0", rows + "\x1b[5;0r" + scroll,
+                    rows + "\x1b[5;24r" + scroll);
+    ok &= checkSame("DECSTBM 5", rows + "\x1b[5r" + scroll,
+                    rows + "\x1b[5;24r" + scroll);
+    ok &= checkSame("DECSTBM 0;10", rows + "\x1b[0;10r\x1b[10;1H\n\nA",
+                    rows + "\x1b[1;10r\x1b[10;1H\n\nA");
+    ok &= checkSame("DECSTBM ;10", rows + "\x1b[;10r\x1b[10;1H\n\nA",
+                    rows + "\x1b[1;10r\x1b[10;1H\n\nA");
+
+    // Lines outside the scroll region are left alone
+    ok &= checkSame("IL/DL below the scroll region",
+                    rows + "\x1b[5;10r\x1b[15;1H\x1b[2L\x1b[3MX",
+                    rows + "\x1b[5;10r\x1b[15;1HX");
+    ok &= checkSame("IL/DL above the scroll region",
+                    rows + "\x1b[5;10r\x1b[2;1H\x1b[L\x1b[MX",
+                    rows + "\x1b[5;10r\x1b[2;1HX");
+
+    // G1 designated as line drawing, invoked with SO and put back with SI
+    ok &= checkSame("SCS with SI/SO", "\x1b)0q\x0eq\x0fq",
+                    "q\x1b(0q\x1b(Bq");
+
+    // CAN and SUB abort whatever sequence they turn up in
+    ok &= checkSame("CAN/SUB aborts",
+                    "\x1b[31\x18" "A\x1b[1;4\x1a" "B\x1b(\x18" "C"
+                    "\x1b]0;title\x18" "D\x1bP1$r\x1a" "E",
+                    "ABCDE");
+
+    ok &= checkSplits("double-byte character wrapping a row",
+                      "\x1b[1;80H\xa4\x40\xa4\x40");
+    ok &= checkSplits("URL wrapping a row",
+                      "\x1b[1;70Hsee http://example.org/a/b/c then");
+
+    foreach (const TerminalBenchmarker::Corpus &corpus, corpora)
+        ok &= checkCorpus(corpus);
+
+    *_cout << (ok ? "All checks passed\n" : "Some checks FAILED\n");
+    _cout->flush();
+    return ok ? 0 : 1;
+}
+
+TerminalChecker::Screen TerminalChecker::screenAfter(
+        const QList<QByteArray> &chunks) const
+{
+    Terminal terminal;
+    terminal.setConnection(new NullConnection(&terminal));
+    foreach (const QByteArray &chunk, chunks)
+        terminal.processIncomingData(chunk);
+
+    Screen screen;
+    for (int y = 0; y < UJ::BBS::SizeRowCount; y++)
+    {
+        const UJ::BBS::Cell *cells = terminal.cellsAtRow(y);
+        for (int x = 0; x < UJ::BBS::SizeColumnCount; x++)
+            screen.cells.append(cells[x]);
+        screen.urlSpans.append(terminal.urlSpansAtRow(y));
+    }
+    screen.cursorRow = terminal.cursorRow();
+    screen.cursorColumn = terminal.cursorColumn();
+    return screen;
+}
+
+QString TerminalChecker::difference(const Screen &screen,
+                                    const Screen &expected) const
+{
+    if (screen.cursorRow != expected.cursorRow ||
+            screen.cursorColumn != expected.cursorColumn)
+    {
+        return QString("cursor at %1,%2, expected %3,%4")
+                .arg(screen.cursorRow).arg(screen.cursorColumn)
+                .arg(expected.cursorRow).arg(expected.cursorColumn);
+    }
+    for (int i = 0; i < screen.cells.size(); i++)
+    {
+        const UJ::BBS::Cell &cell = screen.cells.at(i);
+        const UJ::BBS::Cell &other = expected.cells.at(i);
+        QString where = QString("at %1,%2")
+                .arg(i / UJ::BBS::SizeColumnCount)
+                .arg(i % UJ::BBS::SizeColumnCount);
+        if (cell.byte != other.byte)
+        {
+            return QString("byte %1 %2, expected %3").arg(int(cell.byte))
+                    .arg(where).arg(int(other.byte));
+        }
+        if (cell.attr.f.doubleByte != other.attr.f.doubleByte)
+        {
+            return QString("double-byte state %1 %2, expected %3")
+                    .arg(cell.attr.f.doubleByte).arg(where)
+                    .arg(other.attr.f.doubleByte);
+        }
+        if (cell.attr.v != other.attr.v)
+        {
+            return QString("attributes %1 %2, expected %3")
+                    .arg(cell.attr.v, 0, 16).arg(where)
+                    .arg(other.attr.v, 0, 16);
+        }
+    }
+    for (int y = 0; y < screen.urlSpans.size(); y++)
+    {
+        const QVector<UrlSpan> &spans = screen.urlSpans.at(y);
+        const QVector<UrlSpan> &others = expected.urlSpans.at(y);
+        bool same = spans.size() == others.size();
+        for (int i = 0; same && i < spans.size(); i++)
+        {
+            same = spans.at(i).begin == others.at(i).begin &&
+                   spans.at(i).end == others.at(i).end;
+        }
+        if (!same)
+            return QString("different URL spans in row %1").arg(y);
+    }
+    return QString();
+}
+
+bool TerminalChecker::compare(const QString &name, const Screen &screen,
+                              const Screen &expected)
+{
+    QString diff = difference(screen, expected);
+    if (diff.isEmpty())
+        return true;
+    *_cout << "FAIL " << name << ": " << diff << "\n";
+    _cout->flush();
+    return false;
+}
+
+bool TerminalChecker::checkSplits(const QString &name,
+                                  const QByteArray &stream)
+{
+    QList<QByteArray> chunks;
+    chunks << stream;
+    Screen whole = screenAfter(chunks);
+    for (int cut = 1; cut < stream.size(); cut++)
+    {
+        chunks.clear();
+        chunks << stream.left(cut) << stream.mid(cut);
+        if (!compare(QString("%1, cut at %2").arg(name).arg(cut),
+                     screenAfter(chunks), whole))
+            return false;
+    }
+    return compare(name + ", byte by byte",
+                   screenAfter(chunked(stream, 1)), whole);
+}
+
+bool TerminalChecker::checkSame(const QString &name, const QByteArray &stream,
+                                const QByteArray &expected)
+{
+    if (!checkSplits(name, stream))
+        return false;
+    return compare(name, screenAfter(QList<QByteArray>() << stream),
+                   screenAfter(QList<QByteArray>() << expected));
+}
+
+bool TerminalChecker::checkCorpus(const TerminalBenchmarker::Corpus &corpus)
+{
+    static const int sizes[] = {1, 2, 3, 7, 61, 256, 4093};
+    Screen whole = screenAfter(QList<QByteArray>() << corpus.data);
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+    {
+        QString name = QString("%1, in %2-byte chunks")
+                .arg(corpus.name).arg(sizes[i]);
+        if (!compare(name, screenAfter(chunked(corpus.data, sizes[i])),
+                     whole))
+            return false;
+    }
+    return checkSplits(corpus.name + ", start",
+                       corpus.data.left(CutPrefixSize));
+}
@@ -0,0 +1,65 @@
+/*****************************************************************************
+ * TerminalChecker.h
+ *
+ * Created: 17/10 2026 by uranusjr
+ *
+ * Copyright 2026 uranusjr. All rights reserved.
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ *****************************************************************************/
+
+#ifndef TERMINALCHECKER_H
+#define TERMINALCHECKER_H
+
+#include <UJQxTestUtilities.h>
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include <QVector>
+#include "Globals.h"
+#include "ScreenSnapshot.h"
+#include "TerminalBenchmarker.h"
+
+// Feeds byte streams to Terminal whole, cut in two at every point, and one
+// byte at a time, and checks that the screen comes out the same every time:
+// the cells and their attributes, the double-byte state, the URL spans and
+// the cursor. Sequences, double-byte characters and URLs all carry on across
+// chunks, so where a stream happens to be split must never show. Targeted
+// cases also check that sequences meaning the same thing draw the same.
+class TerminalChecker : public UJ::Qx::Tester
+{
+    Q_OBJECT
+
+public:
+    explicit TerminalChecker(QObject *parent = 0);
+    int run(const QList<TerminalBenchmarker::Corpus> &corpora);
+
+private:
+    // What a terminal shows, copied out of it
+    struct Screen
+    {
+        QVector<UJ::BBS::Cell> cells;
+        QVector<QVector<UJ::Connection::UrlSpan> > urlSpans;
+        int cursorRow;
+        int cursorColumn;
+    };
+
+    Screen screenAfter(const QList<QByteArray> &chunks) const;
+    QString difference(const Screen &screen, const Screen &expected) const;
+    bool compare(const QString &name, const Screen &screen,
+                 const Screen &expected);
+    bool checkSplits(const QString &name, const QByteArray &stream);
+    bool checkSame(const QString &name, const QByteArray &stream,
+                   const QByteArray &expected);
+    bool checkCorpus(const TerminalBenchmarker::Corpus &corpus);
+};
+
+#endif // TERMINALCHECKER_H
@@ -18,19 +18,28 @@ INCLUDEPATH += ../Test
 
 SOURCES += main.cpp \
     ../../src/Terminal.cpp \
+    ../../src/ScreenSnapshot.cpp \
     ../../src/Site.cpp \
     ../../src/Telnet.cpp \
     ../../src/AbstractConnection.cpp \
+    ../../src/IoChannel.cpp \
+    ../../src/UJByteScan.cpp \
     TerminalTester.cpp
 
 HEADERS += \
     ../../src/Terminal.h \
+    ../../src/ScreenSnapshot.h \
+    ../../src/CsiParameters.h \
     ../../src/YLTerminal.h \
     ../../src/UJCommonDefs.h \
     ../../src/Globals.h \
     ../../src/Site.h \
     ../../src/Telnet.h \
     ../../src/AbstractConnection.h \
+    ../../src/DataSink.h \
+    ../../src/IoChannel.h \
+    ../../src/UJByteScan.h \
+    ../../src/UJSpscQueue.h \
     TerminalTester.h \
     ../Test/UJQxTestUtilities.h
 
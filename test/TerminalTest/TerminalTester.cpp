@@ -31,11 +31,17 @@ TerminalTester::TerminalTester(QObject *parent) : Tester(parent)
 
 void TerminalTester::dumpProcessedData()
 {
-    for (int y = 0; y < 24; y++)
+    // The terminal parses on a worker, so read the screen it published,
+    // not the cells it may be writing
+    QSharedPointer<UJ::Connection::ScreenSnapshot> screen =
+            terminal.takeSnapshot();
+    if (!screen)
+        return;
+    for (int y = 0; y < screen->rowCount(); y++)
     {
-        UJ::BBS::Cell *cells = terminal.cellsAtRow(y);
+        const UJ::BBS::Cell *cells = screen->cellsAtRow(y);
         QByteArray row;
-        for (int x = 0; x < 80; x++)
+        for (int x = 0; x < screen->columnCount(); x++)
             row.append(cells[x].byte);
         QTextCodec *codec = QTextCodec::codecForName("Big5");
         QString string = codec->toUnicode(row);